@@ -0,0 +1,211 @@
+// Aggregate helpers that do not depend on the value type
+
+#include <cstdlib>
+#include <climits>
+#include "aggregate.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#endif
+
+namespace {
+  long long GCD(long long x, long long y) {
+    while (y != 0) {
+      long long t = x % y;
+      x = y;
+      y = t;
+    }
+    return x;
+  }
+
+  //Write n/d in the same mixed number format as Fraction's << operator
+  void writeExact(ostream& out, long long n, long long d) {
+    long long gcd = GCD(llabs(n), d);
+    if (gcd > 1) {
+      n /= gcd;
+      d /= gcd;
+    }
+
+    if (n == 0) {
+      out << "0";
+      return;
+    }
+
+    if (n < 0)
+      out << "-";
+
+    long long i = llabs(n / d);
+    if (i > 0)
+      out << i;
+
+    long long r = llabs(n % d);
+    if (d > 1 && r > 0) {
+      if (i > 0)
+        out << "+";
+      out << r << "/" << d;
+    }
+  }
+}
+
+/*
+* Reduce a block of ints to sum, min and max.
+* Four lanes are processed at a time with SSE2 (SSE4.1 min/max when available),
+* each lane's sum is widened to 64 bits so the block total can not wrap.
+*
+* Complexity: O(n)
+*/
+void reduceInts(const int* vals, size_t n, long long& sum, int& min, int& max) {
+  size_t i = 0;
+  sum = 0;
+  min = INT_MAX;
+  max = INT_MIN;
+
+#ifdef __SSE2__
+  if (n >= 4) {
+    __m128i vmin = _mm_set1_epi32(INT_MAX);
+    __m128i vmax = _mm_set1_epi32(INT_MIN);
+    __m128i vsum = _mm_setzero_si128();
+
+    for (; i + 4 <= n; i += 4) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(vals + i));
+
+#ifdef __SSE4_1__
+      vmin = _mm_min_epi32(vmin, v);
+      vmax = _mm_max_epi32(vmax, v);
+#else
+      __m128i lt = _mm_cmplt_epi32(v, vmin);
+      vmin = _mm_or_si128(_mm_and_si128(lt, v), _mm_andnot_si128(lt, vmin));
+      __m128i gt = _mm_cmpgt_epi32(v, vmax);
+      vmax = _mm_or_si128(_mm_and_si128(gt, v), _mm_andnot_si128(gt, vmax));
+#endif
+
+      //Sign extend the four lanes to 64 bits before adding
+      __m128i sign = _mm_srai_epi32(v, 31);
+      vsum = _mm_add_epi64(vsum, _mm_unpacklo_epi32(v, sign));
+      vsum = _mm_add_epi64(vsum, _mm_unpackhi_epi32(v, sign));
+    }
+
+    int mins[4], maxs[4];
+    long long sums[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(mins), vmin);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(maxs), vmax);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(sums), vsum);
+
+    sum = sums[0] + sums[1];
+    for (int lane = 0; lane < 4; ++lane) {
+      if (mins[lane] < min)
+        min = mins[lane];
+      if (maxs[lane] > max)
+        max = maxs[lane];
+    }
+  }
+#endif
+
+  //Remaining values (or all of them without SIMD support)
+  for (; i < n; ++i) {
+    sum += vals[i];
+    if (vals[i] < min)
+      min = vals[i];
+    if (vals[i] > max)
+      max = vals[i];
+  }
+}
+
+
+// ValueSum<int>
+
+void ValueSum<int>::write(ostream& out) const {
+  out << total;
+}
+
+void ValueSum<int>::writeAverage(ostream& out, size_t count) const {
+  out << double(total) / count;
+}
+
+
+// ValueSum<Fraction>
+
+/*
+* Add n/d to the running sum.
+* Equal denominators are added directly, otherwise the sum is brought to the least common denominator.
+* Like Fraction::operator+ the result is reduced, but only once the denominator no longer fits an int,
+* so long runs of values over a few denominators rarely pay for a GCD. Overflow of the 64 bit
+* numerator or denominator is detected and makes the sum invalid rather than wrong.
+*
+* Complexity: O(1) amortised, O(log d) when reducing
+*/
+void ValueSum<Fraction>::add(long long n, long long d) {
+  //A zero denominator has no exact sum either
+  if (overflow || d == 0) {
+    overflow = true;
+    return;
+  }
+
+  if (d == denominator) {
+    overflow = __builtin_add_overflow(numerator, n, &numerator);
+    return;
+  }
+
+  long long gcd = GCD(denominator, d);
+  long long scaled = 0;
+  overflow = __builtin_mul_overflow(numerator, d / gcd, &numerator)
+          || __builtin_mul_overflow(n, denominator / gcd, &scaled)
+          || __builtin_add_overflow(numerator, scaled, &numerator)
+          || __builtin_mul_overflow(denominator, d / gcd, &denominator);
+
+  if (!overflow && denominator > INT_MAX) {
+    gcd = GCD(llabs(numerator), denominator);
+    if (gcd > 1) {
+      numerator /= gcd;
+      denominator /= gcd;
+    }
+  }
+}
+
+void ValueSum<Fraction>::write(ostream& out) const {
+  writeExact(out, numerator, denominator);
+}
+
+void ValueSum<Fraction>::writeAverage(ostream& out, size_t count) const {
+  long long gcd = GCD(llabs(numerator), (long long)count);
+  long long d;
+
+  //Dividing out common factors first keeps the denominator small
+  if (__builtin_mul_overflow(denominator, (long long)count / gcd, &d))
+    out << double(numerator) / denominator / count;
+  else
+    writeExact(out, numerator / gcd, d);
+}
+
+
+// ValueSum<TypedValue>
+
+/*
+* Complexity: O(1) amortised, see ValueSum<Fraction>::add
+*/
+void ValueSum<TypedValue>::add(const TypedValue& val) {
+  if (!val.isNumber())
+    return;
+
+  numbers.add(val.fractionValue());
+  fractional |= val.denominator() != 1;
+  ++count;
+}
+
+void ValueSum<TypedValue>::merge(const ValueSum& other) {
+  numbers.merge(other.numbers);
+  count += other.count;
+  fractional |= other.fractional;
+}
+
+void ValueSum<TypedValue>::writeAverage(ostream& out, size_t) const {
+  if (count == 0)
+    out << "none";
+  else if (!fractional)
+    out << numbers.approximate() / count;
+  else
+    numbers.writeAverage(out, count);
+}
@@ -0,0 +1,146 @@
+/**
+*  Aggregate class which accumulates count, min, max and sum of database values in one pass.
+*
+*  Sums are only defined for numeric values: ints are summed into a 64 bit total
+*  (blocks of ints are reduced with SIMD instructions where available) and Fractions
+*  are summed exactly, as are the numbers of a typed database, whose strings are
+*  left out of its sum. Other value types support count, min and max only.
+*
+*  Author: Mohammad Ghasembeigi
+*
+*/
+
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+#include "fraction.h"
+#include "typedvalue.h"
+
+/* ValueSum
+* --------
+* Running sum of values, specialised for each summable type.
+* The primary template is used for values that have no meaningful sum.
+*/
+template <class value>
+class ValueSum {
+public:
+  static const bool Supported = false;
+
+  inline void add(const value&) {}
+  inline void merge(const ValueSum&) {}
+  inline bool overflowed() const { return false; }
+  inline double approximate() const { return 0; }
+  void write(ostream&) const {}
+  void writeAverage(ostream&, size_t) const {}
+};
+
+//Ints are summed into a 64 bit total so sums of many 32 bit values do not wrap
+template <>
+class ValueSum<int> {
+public:
+  static const bool Supported = true;
+
+  ValueSum() : total(0), overflow(false) {}
+
+  inline void add(int val) { addTotal(val); }
+  inline void merge(const ValueSum& other) { addTotal(other.total); overflow |= other.overflow; }
+  void addBlock(long long blockTotal) { addTotal(blockTotal); }
+  inline bool overflowed() const { return overflow; }
+  inline double approximate() const { return total; }
+  void write(ostream& out) const;
+  void writeAverage(ostream& out, size_t count) const;
+
+private:
+  long long total;
+  bool overflow;
+
+  inline void addTotal(long long val) { overflow |= __builtin_add_overflow(total, val, &total); }
+};
+
+//Fractions are summed exactly in 64 bit, reducing whenever the denominator outgrows an int
+template <>
+class ValueSum<Fraction> {
+public:
+  static const bool Supported = true;
+
+  ValueSum() : numerator(0), denominator(1), overflow(false) {}
+
+  inline void add(const Fraction& f) { add(f.Numerator(), f.Denominator()); }
+  inline void merge(const ValueSum& other) { overflow |= other.overflow; add(other.numerator, other.denominator); }
+  inline bool overflowed() const { return overflow; }
+  inline double approximate() const { return double(numerator) / denominator; }
+  void write(ostream& out) const;
+  void writeAverage(ostream& out, size_t count) const;
+
+private:
+  long long numerator;
+  long long denominator;
+  bool overflow;
+
+  void add(long long n, long long d);
+};
+
+//Numbers of a typed database are summed exactly as Fractions, strings are skipped. Averages are over
+//the numbers alone, and are written as for ints while no number is fractional
+template <>
+class ValueSum<TypedValue> {
+public:
+  static const bool Supported = true;
+
+  ValueSum() : numbers(), count(0), fractional(false) {}
+
+  void add(const TypedValue& val);
+  void merge(const ValueSum& other);
+  inline bool overflowed() const { return numbers.overflowed(); }
+  inline double approximate() const { return numbers.approximate(); }
+  inline void write(ostream& out) const { numbers.write(out); }
+  void writeAverage(ostream& out, size_t) const;
+
+private:
+  ValueSum<Fraction> numbers;
+  size_t count;       //numbers added
+  bool fractional;    //some number added was not whole
+};
+
+//Reduce a block of ints to its sum, min and max, n must be at least 1
+void reduceInts(const int* vals, size_t n, long long& sum, int& min, int& max);
+
+
+template <class value>
+class Aggregate {
+public:
+  //Default constructor
+  Aggregate<value>() : count_(0), min_(), max_(), sum_() {}
+
+  //Member functions
+
+  //Complexity of inlines: O(1)
+  inline size_t count() const { return count_; }
+  inline const value& min() const { return min_; }
+  inline const value& max() const { return max_; }
+  inline const ValueSum<value>& sum() const { return sum_; }
+  inline bool hasSum() const { return ValueSum<value>::Supported; }
+
+  void add(const value& val);
+  void addBlock(const value* vals, size_t n);
+  void merge(const Aggregate<value>& other);
+
+  //Default Destructor
+  ~Aggregate() {};
+
+private:
+  size_t count_;
+  value min_;
+  value max_;
+  ValueSum<value> sum_;
+
+};
+
+#include "aggregate.tem"
+
+#endif
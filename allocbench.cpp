@@ -0,0 +1,127 @@
+/**
+*  Check that reading records makes a constant number of heap allocations per record.
+*
+*  Built with allocstats.cpp compiled with COUNT_ALLOCATIONS, so every allocation is
+*  counted. N and then 2N generated records are read, once with >> into a vector and
+*  once with Database::read. Each record needs the allocations of its own storage,
+*  measured by copying a record, and reading may only add a small amortised amount on
+*  top of that: buffers and vectors that grow geometrically or per block. Allocations
+*  per record must stay within that bound and must not grow with the number of records.
+*
+*  Usage: allocbench [records]
+*  Return: 0 if reading stays within the bound, 1 otherwise
+*
+*  Author: Mohammad Ghasembeigi
+*
+*/
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+using namespace std;
+
+#include "allocstats.h"
+#include "database.h"
+
+namespace {
+  //Allocations per record reading may make beyond the record's own storage
+  const double Overhead = 1.0;
+
+  //Growth allowed in allocations per record from N to 2N records, covering geometric growth
+  const double Growth = 0.1;
+
+  string generate(size_t n) {
+    ostringstream out;
+    for (size_t i = 0; i < n; ++i) {
+      out << "{\n  part number = " << i << "\n  number in stock = " << i * 7 % 50
+          << "\n  supplier cost = " << i * 13 % 90 << "\n  retail cost = " << i * 26 % 180 << "\n}\n";
+    }
+    return out.str();
+  }
+
+  //Allocations made by f
+  template <class F>
+  unsigned long counted(F f) {
+    unsigned long before = AllocationStats::allocations();
+    f();
+    return AllocationStats::allocations() - before;
+  }
+
+  template <class value>
+  double readRecords(const string& text) {
+    istringstream in(text);
+    vector<Record<value>> records;
+    Record<value> r;
+    size_t n = 0;
+
+    unsigned long allocations = counted([&]() {
+      while (in >> r) {
+        records.push_back(std::move(r));
+      }
+      n = records.size();
+    });
+    return double(allocations) / n;
+  }
+
+  template <class value>
+  double readDatabase(const string& text) {
+    istringstream in(text);
+    Database<value> db;
+    size_t n = 0;
+
+    unsigned long allocations = counted([&]() {
+      db.read(in);
+      n = db.numRecords();
+    });
+    return double(allocations) / n;
+  }
+
+  template <class value>
+  bool check(const char* name, size_t n) {
+    string text = generate(n), doubled = generate(2 * n);
+
+    istringstream in(text);
+    Record<value> r;
+    in >> r;
+    unsigned long own = counted([&]() { Record<value> copy(r); });
+
+    bool within = true;
+    double single[] = { readRecords<value>(text), readDatabase<value>(text) };
+    double twice[] = { readRecords<value>(doubled), readDatabase<value>(doubled) };
+    const char* how[] = { ">>", "Database::read" };
+
+    for (int i = 0; i < 2; ++i) {
+      cout << name << " " << how[i] << ": " << single[i] << " allocations per record for " << n << " records, "
+           << twice[i] << " for " << 2 * n << ", the record itself needs " << own << "\n";
+
+      if (twice[i] > own + Overhead || single[i] > own + Overhead) {
+        cout << "ERROR: " << name << " " << how[i] << " allocates more than its records need.\n";
+        within = false;
+      }
+      if (twice[i] > single[i] + Growth) {
+        cout << "ERROR: " << name << " " << how[i] << " allocations per record grow with the number of records.\n";
+        within = false;
+      }
+    }
+    return within;
+  }
+}
+
+int main(int argc, char* argv[]) {
+  if (!AllocationStats::enabled) {
+    cout << "ERROR: allocbench must be built with COUNT_ALLOCATIONS.\n";
+    return 1;
+  }
+
+  size_t n = argc < 2 ? 50000 : atoi(argv[1]);
+  bool within = check<int>("int", n);
+  within = check<string>("string", n) && within;
+  within = check<TypedValue>("typed", n) && within;
+
+  cout << (within ? "Reading allocates a constant number of times per record.\n"
+                  : "Reading does not allocate a constant number of times per record.\n");
+  return within ? 0 : 1;
+}
@@ -0,0 +1,56 @@
+// AllocationStats implementation, along with the counting operator new and delete
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "allocstats.h"
+
+namespace {
+  //Constant initialised, so allocations made before main are counted too
+  atomic<unsigned long> allocationCount(0);
+  atomic<unsigned long> allocationBytes(0);
+}
+
+#ifdef COUNT_ALLOCATIONS
+
+const bool AllocationStats::enabled = true;
+
+/*
+* Count the allocation and take the memory from malloc
+* Complexity: O(1) plus the cost of malloc
+*/
+void* operator new(size_t size) {
+  allocationCount.fetch_add(1, memory_order_relaxed);
+  allocationBytes.fetch_add(size, memory_order_relaxed);
+
+  void* p = malloc(size == 0 ? 1 : size);
+  if (p == NULL)
+    throw bad_alloc();
+  return p;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  free(p);
+}
+
+#else
+
+const bool AllocationStats::enabled = false;
+
+#endif
+
+unsigned long AllocationStats::allocations() {
+  return allocationCount.load(memory_order_relaxed);
+}
+
+unsigned long AllocationStats::bytes() {
+  return allocationBytes.load(memory_order_relaxed);
+}
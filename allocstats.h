@@ -0,0 +1,28 @@
+/**
+*  Heap allocation accounting, for measuring what operations cost in allocations.
+*
+*  When built with COUNT_ALLOCATIONS defined, allocstats.cpp replaces the global
+*  operator new and delete with versions that count every allocation and the bytes
+*  requested, and the interactive shell reports the counts for each command. In a
+*  normal build nothing is replaced and the counts stay at zero.
+*
+*  Author: Mohammad Ghasembeigi
+*
+*/
+
+#ifndef ALLOCSTATS_H
+#define ALLOCSTATS_H
+
+using namespace std;
+
+class AllocationStats {
+public:
+  //true when built with COUNT_ALLOCATIONS
+  static const bool enabled;
+
+  //Totals since the program started, across all threads
+  static unsigned long allocations();
+  static unsigned long bytes();
+};
+
+#endif
@@ -0,0 +1,49 @@
+// AttributeNames implementation
+
+#include <unordered_set>
+#include <mutex>
+#include "attribute.h"
+#include "memoryusage.h"
+
+namespace {
+  //Node based set, so pointers to names stay valid as more are added
+  unordered_set<string>& names() {
+    static unordered_set<string> pool;
+    return pool;
+  }
+
+  //Records may be parsed on several threads at once
+  mutex& namesLock() {
+    static mutex lock;
+    return lock;
+  }
+}
+
+/*
+* Complexity: O(k) expected where k is the length of name
+*/
+Attribute AttributeNames::intern(const string& name) {
+  lock_guard<mutex> guard(namesLock());
+  return &*names().insert(name).first;
+}
+
+/*
+* Complexity: O(k) expected where k is the length of name
+*/
+Attribute AttributeNames::find(const string& name) {
+  lock_guard<mutex> guard(namesLock());
+  auto it = names().find(name);
+  return it == names().end() ? NULL : &*it;
+}
+
+/*
+* Complexity: O(a) in the number of names
+*/
+size_t AttributeNames::memoryUsage() {
+  lock_guard<mutex> guard(namesLock());
+  size_t bytes = hashTableBytes(names());
+  for (auto it = names().begin(); it != names().end(); ++it) {
+    bytes += stringBytes(*it);
+  }
+  return bytes;
+}
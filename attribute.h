@@ -0,0 +1,34 @@
+/**
+*  Interned attribute names shared by every record.
+*
+*  Each distinct attribute name is stored once and records refer to it by
+*  pointer, so records do not keep their own copies of names and comparing
+*  or hashing attributes is a pointer operation rather than a string one.
+*
+*  Author: Mohammad Ghasembeigi
+*
+*/
+
+#ifndef ATTRIBUTE_H
+#define ATTRIBUTE_H
+
+#include <string>
+
+using namespace std;
+
+//An interned attribute name, equal names always share the same pointer
+typedef const string* Attribute;
+
+class AttributeNames {
+public:
+  //Interned name equal to name, adding it if it is new
+  static Attribute intern(const string& name);
+
+  //Interned name equal to name, NULL if no record has ever used it
+  static Attribute find(const string& name);
+
+  //Memory held by every interned name
+  static size_t memoryUsage();
+};
+
+#endif
@@ -0,0 +1,125 @@
+// AttributeTypes implementation for typed databases
+
+#include "attributetypes.h"
+
+/*
+* Note the types of the values of a record. An attribute seen for the first time takes the type of
+* its first value. A wider value widens an inferred type, while a declared type keeps it as a misfit.
+* Either way the attribute is mixed when values of another type have to be converted.
+*
+* Complexity: O(k) expected in the number of values of the record
+*/
+void AttributeTypes<TypedValue>::observe(const Record<TypedValue>& r) {
+  r.forEachAttribute([&](Attribute attr, const vector<TypedValue>& vals) {
+    if (vals.empty())
+      return;
+
+    //Looked up before inserting, as emplace allocates a node even for an attribute already known
+    auto it = types.find(attr);
+    if (it == types.end())
+      it = types.emplace(attr, AttributeType(vals.front().type())).first;
+
+    AttributeType& type = it->second;
+    for (auto vit = vals.begin(); vit != vals.end(); ++vit) {
+      if (vit->type() == type.type)
+        continue;
+
+      if (vit->type() > type.type && type.declared)
+        ++type.misfits;
+      else {
+        if (vit->type() > type.type)
+          type.type = vit->type();
+        type.mixed = mixed = true;
+      }
+    }
+  });
+}
+
+/*
+* Convert every value of a mixed attribute to its type where that keeps its text, counting the
+* values of a declared type that can not be again.
+*
+* Complexity: O(1) if no attribute is mixed, O(n * m) otherwise where m is the number of mixed attributes
+*/
+bool AttributeTypes<TypedValue>::normalise(vector<Record<TypedValue>>& records) {
+  if (!mixed)
+    return false;
+
+  vector<pair<Attribute, AttributeType*>> changed;
+  for (auto it = types.begin(); it != types.end(); ++it) {
+    if (it->second.mixed) {
+      it->second.mixed = false;
+      it->second.misfits = 0;
+      changed.push_back(make_pair(it->first, &it->second));
+    }
+  }
+  mixed = false;
+
+  for (auto rit = records.begin(); rit != records.end(); ++rit) {
+    for (auto cit = changed.begin(); cit != changed.end(); ++cit) {
+      AttributeType& type = *cit->second;
+      rit->changeValues(cit->first, [&type](TypedValue& val) {
+        if (val.type() != type.type && !val.convert(type.type))
+          ++type.misfits;
+      });
+    }
+  }
+
+  return true;
+}
+
+/*
+* Complexity: O(1) expected, plus O(k) in the length of the text when converting to or from a string
+*/
+void AttributeTypes<TypedValue>::convert(Attribute attr, TypedValue& val) const {
+  auto it = types.find(attr);
+  if (it != types.end() && val.type() != it->second.type)
+    val.convert(it->second.type);
+}
+
+/*
+* A value that does not fit a declared type stays a misfit, which the next normalise counts.
+* Complexity: O(1) expected, plus O(k) in the length of the text when converting to or from a string
+*/
+void AttributeTypes<TypedValue>::updated(Attribute attr, TypedValue& val) {
+  auto it = types.find(attr);
+  if (it == types.end()) {
+    types.emplace(attr, AttributeType(val.type()));
+    return;
+  }
+
+  AttributeType& type = it->second;
+  if (val.type() == type.type || val.convert(type.type))
+    return;
+
+  if (!type.declared)
+    type.type = val.type();
+  type.mixed = mixed = true;
+}
+
+/*
+* Complexity: O(1) expected
+*/
+void AttributeTypes<TypedValue>::declare(Attribute attr, ValueType type) {
+  AttributeType& declared = types[attr];
+  declared.type = type;
+  declared.declared = true;
+  declared.mixed = mixed = true;
+}
+
+/*
+* Complexity: O(a) in the number of attributes
+*/
+void AttributeTypes<TypedValue>::clear() {
+  for (auto it = types.begin(); it != types.end(); ) {
+    if (!it->second.declared) {
+      it = types.erase(it);
+      continue;
+    }
+
+    it->second.mixed = false;
+    it->second.misfits = 0;
+    ++it;
+  }
+  mixed = false;
+}
@@ -0,0 +1,106 @@
+/**
+*  Types of the attributes of a database, kept by typed databases only.
+*
+*  The type of an attribute is declared, or else inferred as the widest type of its
+*  values, so an attribute holding ints and Fractions is a fraction attribute and one
+*  holding any string is a string attribute. Values are brought to the type of their
+*  attribute wherever that keeps their text, after which comparisons on an attribute
+*  only see values of one type. A declared type is kept even when some values can not
+*  be written as it, such as "N/A" in an int attribute: those keep their own type and
+*  never order against a number, so they match neither < nor > in a query.
+*
+*  Databases of other values have no types to keep, the primary template does nothing.
+*
+*  Author: Mohammad Ghasembeigi
+*
+*/
+
+#ifndef ATTRIBUTETYPES_H
+#define ATTRIBUTETYPES_H
+
+#include <vector>
+#include <unordered_map>
+
+using namespace std;
+
+#include "record.h"
+#include "typedvalue.h"
+
+/* AttributeType
+* -------------
+* Type of one attribute, whether it was declared, how many values do not fit it and
+* whether some values that do still have to be converted to it.
+*/
+struct AttributeType {
+  AttributeType(ValueType type = IntValue, bool declared = false) : type(type), declared(declared), mixed(false), misfits(0) {}
+
+  ValueType type;
+  bool declared;
+  bool mixed;
+  size_t misfits;
+};
+
+/* AttributeTypes
+* --------------
+* Primary template, used for databases of a single value type.
+*/
+template <class value>
+class AttributeTypes {
+public:
+  static const bool Typed = false;
+
+  inline void observe(const Record<value>&) {}
+  inline bool normalise(vector<Record<value>>&) { return false; }
+  inline void convert(Attribute, value&) const {}
+  inline void updated(Attribute, value&) {}
+  inline void declare(Attribute, ValueType) {}
+  inline void clear() {}
+  template <class Visitor> void forEachType(Visitor) const {}
+};
+
+template <>
+class AttributeTypes<TypedValue> {
+public:
+  static const bool Typed = true;
+
+  //Default constructor
+  AttributeTypes() : types(unordered_map<Attribute, AttributeType>()), mixed(false) {}
+
+  //Member functions
+
+  //Note the types of the values of a record read or appended, widening inferred types
+  void observe(const Record<TypedValue>& r);
+
+  //Convert the values of attributes whose type changed, or that hold values of a narrower type
+  //Return: true if any value may have changed type
+  bool normalise(vector<Record<TypedValue>>& records);
+
+  //Bring val to the type of attr if it keeps its text, as query values are
+  void convert(Attribute attr, TypedValue& val) const;
+
+  //Bring a value about to be stored in attr to its type, or widen an inferred type to that of val
+  void updated(Attribute attr, TypedValue& val);
+
+  //Fix the type of attr, its values are converted by the next normalise
+  void declare(Attribute attr, ValueType type);
+
+  //Forget the inferred types, ready for a new read. Declared types are kept
+  void clear();
+
+  //Calls visit(attribute, type) for every attribute, in no particular order
+  template <class Visitor> void forEachType(Visitor visit) const {
+    for (auto it = types.begin(); it != types.end(); ++it) {
+      visit(it->first, it->second);
+    }
+  }
+
+  //Default Destructor
+  ~AttributeTypes() {};
+
+private:
+  unordered_map<Attribute, AttributeType> types;
+  bool mixed;   //some attribute is mixed
+
+};
+
+#endif
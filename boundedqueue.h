@@ -0,0 +1,48 @@
+/**
+*  Blocking first in first out queue of limited capacity, used to pass work between threads.
+*
+*  Producers wait while the queue is full and consumers while it is empty, so a
+*  fast producer can never get more than capacity items ahead of its consumers.
+*  Closing the queue wakes everyone: pushes then fail and pops drain what is left.
+*
+*  Author: Mohammad Ghasembeigi
+*
+*/
+
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+template <class T>
+class BoundedQueue {
+public:
+  //Constructor
+  BoundedQueue<T>(size_t capacity) : capacity(capacity), closed(false), items(deque<T>()) {}
+
+  //Member functions
+  bool push(T&& item);
+  bool pop(T& item);
+  void close();
+
+  //Default Destructor
+  ~BoundedQueue() {};
+
+private:
+  size_t capacity;
+  bool closed;
+  deque<T> items;
+
+  mutex lock;
+  condition_variable notFull;
+  condition_variable notEmpty;
+
+};
+
+#include "boundedqueue.tem"
+
+#endif
@@ -0,0 +1,183 @@
+// BufferPool implementation
+
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include "bufferpool.h"
+
+/*
+* Create an anonymous scratch file and allocate frames for budgetBytes of pages (at least 2).
+* The file is unlinked straight away so it disappears with the process.
+*
+* Complexity: O(f) where f is the number of frames
+* Return: false if the scratch file could not be created
+*/
+bool BufferPool::open(size_t budgetBytes) {
+  close();
+
+  const char* dir = getenv("TMPDIR");
+  string path = string(dir != NULL ? dir : "/tmp") + "/dbpagesXXXXXX";
+  vector<char> name(path.begin(), path.end());
+  name.push_back('\0');
+
+  fd = mkstemp(name.data());
+  if (fd < 0)
+    return false;
+  unlink(name.data());
+
+  size_t count = budgetBytes / PageSize;
+  frames.resize(count < 2 ? 2 : count);
+  return true;
+}
+
+/*
+* Drop every page and the scratch file.
+* Complexity: O(f)
+*/
+void BufferPool::close() {
+  if (fd >= 0)
+    ::close(fd);
+
+  fd = -1;
+  frames.clear();
+  table.clear();
+  hand = 0;
+  filePages = 0;
+  hits = misses = 0;
+  failed = false;
+}
+
+/*
+* Copy length bytes starting at offset out of the pages.
+* Complexity: O(length), plus I/O for pages not in memory
+* Return: false if the pool has failed
+*/
+bool BufferPool::read(size_t offset, char* dst, size_t length) {
+  while (length > 0) {
+    size_t inPage = offset % PageSize;
+    size_t chunk = min(length, PageSize - inPage);
+
+    memcpy(dst, fetch(offset / PageSize, false) + inPage, chunk);
+    offset += chunk;
+    dst += chunk;
+    length -= chunk;
+  }
+  return !failed;
+}
+
+/*
+* Copy length bytes into the pages starting at offset, the pages are written back to the file when evicted.
+* Complexity: O(length), plus I/O for partially written pages not in memory
+* Return: false if the pool has failed, including while writing back a page evicted to make room
+*/
+bool BufferPool::write(size_t offset, const char* src, size_t length) {
+  while (length > 0) {
+    size_t inPage = offset % PageSize;
+    size_t chunk = min(length, PageSize - inPage);
+
+    //A page that is about to be overwritten from its start does not need to be read first
+    char* page = fetch(offset / PageSize, inPage == 0);
+    memcpy(page + inPage, src, chunk);
+    frames[table[offset / PageSize]].dirty = true;
+
+    offset += chunk;
+    src += chunk;
+    length -= chunk;
+  }
+  return !failed;
+}
+
+
+//Private Helper functions
+
+/*
+* Frame holding page, loading it (and hinting readahead of the following pages) on a miss.
+* Complexity: O(1) on a hit, O(f) worst case to find a victim on a miss
+*/
+char* BufferPool::fetch(size_t page, bool willOverwrite) {
+  auto it = table.find(page);
+  if (it != table.end()) {
+    ++hits;
+    frames[it->second].referenced = true;
+    return frames[it->second].data.data();
+  }
+
+  ++misses;
+  size_t index = victim();
+  Frame& frame = frames[index];
+  frame.data.resize(PageSize);
+
+  if (page < filePages && !willOverwrite) {
+    ssize_t got = pread(fd, frame.data.data(), PageSize, page * PageSize);
+    if (got < 0) {
+      failed = true;
+      got = 0;
+    }
+    memset(frame.data.data() + got, 0, PageSize - got);
+
+    //Sequential scans will want the next pages soon, let the kernel fetch them in the background
+    posix_fadvise(fd, (page + 1) * PageSize, ReadAhead * PageSize, POSIX_FADV_WILLNEED);
+  }
+  else {
+    memset(frame.data.data(), 0, PageSize);
+  }
+
+  frame.page = page;
+  frame.used = true;
+  frame.dirty = false;
+  frame.referenced = true;
+  table[page] = index;
+  return frame.data.data();
+}
+
+/*
+* Choose a frame to load into with the clock algorithm: sweep the frames, giving recently
+* referenced pages a second chance, and evict the first unreferenced one.
+*
+* Complexity: O(f) worst case, O(1) amortised
+*/
+size_t BufferPool::victim() {
+  while (true) {
+    Frame& frame = frames[hand];
+    size_t index = hand;
+    hand = (hand + 1) % frames.size();
+
+    if (!frame.used)
+      return index;
+
+    if (frame.referenced) {
+      frame.referenced = false;
+      continue;
+    }
+
+    writeBack(frame);
+    table.erase(frame.page);
+    frame.used = false;
+    return index;
+  }
+}
+
+/*
+* Write a dirty frame to its page in the scratch file. The page is lost if the write fails,
+* which fails the pool.
+* Complexity: O(PageSize)
+*/
+void BufferPool::writeBack(Frame& frame) {
+  if (!frame.dirty)
+    return;
+
+  size_t done = 0;
+  while (done < PageSize) {
+    ssize_t put = pwrite(fd, frame.data.data() + done, PageSize - done, frame.page * PageSize + done);
+    if (put <= 0) {
+      failed = true;
+      return;
+    }
+    done += put;
+  }
+
+  frame.dirty = false;
+  if (frame.page >= filePages)
+    filePages = frame.page + 1;
+}
@@ -0,0 +1,80 @@
+/**
+*  Buffer pool caching fixed size pages of a scratch file in a bounded amount of memory.
+*
+*  Pages are loaded on demand into a fixed number of frames and evicted with the
+*  clock (second chance) algorithm once every frame is in use, dirty pages are
+*  written back when evicted. On a miss the kernel is asked to read ahead the
+*  following pages, so sequential scans run at close to sequential disk speed.
+*  A failed read or write of the scratch file fails the pool for good, like the
+*  bad bit of a stream, as the pages it held can no longer be trusted.
+*
+*  Author: Mohammad Ghasembeigi
+*
+*/
+
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+using namespace std;
+
+class BufferPool {
+public:
+  static const size_t PageSize = 64 * 1024;
+  static const size_t ReadAhead = 16;  //pages requested from the kernel after a miss
+
+  //Default constructor
+  BufferPool() : fd(-1), frames(vector<Frame>()), table(unordered_map<size_t, size_t>()), hand(0), filePages(0), hits(0), misses(0), failed(false) {}
+
+  //Member functions
+  bool open(size_t budgetBytes);
+  void close();
+
+  //Return: false once the pool has failed, the bytes copied are then not to be trusted
+  bool read(size_t offset, char* dst, size_t length);
+  bool write(size_t offset, const char* src, size_t length);
+
+  //Complexity of inlines: O(1)
+  inline bool good() const { return !failed; }
+  inline size_t capacity() const { return frames.size() * PageSize; }
+  inline size_t numHits() const { return hits; }
+  inline size_t numMisses() const { return misses; }
+
+  //Removes the scratch file
+  ~BufferPool() { close(); }
+
+private:
+  struct Frame {
+    Frame() : page(0), used(false), dirty(false), referenced(false), data(vector<char>()) {}
+
+    size_t page;
+    bool used;
+    bool dirty;
+    bool referenced;  //second chance bit for the clock
+    vector<char> data;
+  };
+
+  int fd;                                //scratch file, unlinked as soon as it is created
+  vector<Frame> frames;
+  unordered_map<size_t, size_t> table;   //page number to frame index
+  size_t hand;                           //clock hand
+  size_t filePages;                      //pages that exist in the scratch file
+  size_t hits;
+  size_t misses;
+  bool failed;                           //a read or write of the scratch file failed
+
+  //Private helper functions
+  char* fetch(size_t page, bool willOverwrite);
+  size_t victim();
+  void writeBack(Frame& frame);
+
+  //Pools own their scratch file
+  BufferPool(const BufferPool&);
+  BufferPool& operator=(const BufferPool&);
+
+};
+
+#endif
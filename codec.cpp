@@ -0,0 +1,224 @@
+// Record codec helpers that do not depend on the value type
+
+#include <climits>
+#include "codec.h"
+
+namespace {
+  const char Magic[4] = { 'D', 'B', 'Z', '1' };
+}
+
+void writeCodecHeader(ostream& out) {
+  out.write(Magic, sizeof(Magic));
+}
+
+bool readCodecHeader(istream& in) {
+  char magic[sizeof(Magic)];
+  return in.read(magic, sizeof(magic)) && string(magic, sizeof(magic)) == string(Magic, sizeof(Magic));
+}
+
+/*
+* Seven bits per byte, least significant first, the high bit marks that more bytes follow.
+* Bytes go straight through the stream buffer as this is called for every number.
+*
+* Complexity: O(1), at most 10 bytes
+*/
+void writeVarint(ostream& out, uint64_t v) {
+  streambuf* buf = out.rdbuf();
+  while (v >= 0x80) {
+    buf->sputc(char(v | 0x80));
+    v >>= 7;
+  }
+  buf->sputc(char(v));
+}
+
+bool readVarint(istream& in, uint64_t& v) {
+  streambuf* buf = in.rdbuf();
+  v = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    int c = buf->sbumpc();
+    if (c == EOF)
+      return false;
+
+    v |= uint64_t(c & 0x7f) << shift;
+    if ((c & 0x80) == 0)
+      return true;
+  }
+
+  //More than 10 bytes can not be a 64 bit number
+  return false;
+}
+
+/*
+* Length prefixed bytes.
+* Complexity: O(k) in the length of s
+*/
+void writeBytes(ostream& out, const string& s) {
+  writeVarint(out, s.length());
+  out.rdbuf()->sputn(s.data(), s.length());
+}
+
+bool readBytes(istream& in, string& s) {
+  uint64_t length;
+  if (!readVarint(in, length))
+    return false;
+
+  //Grow as bytes arrive rather than trusting a corrupt length with one huge allocation
+  s.clear();
+  char chunk[4096];
+  while (length > 0) {
+    streamsize want = length < sizeof(chunk) ? length : sizeof(chunk);
+    if (in.rdbuf()->sgetn(chunk, want) != want)
+      return false;
+    s.append(chunk, want);
+    length -= want;
+  }
+  return true;
+}
+
+
+// StringDictionary
+
+/*
+* Complexity: O(k) expected in the length of s
+*/
+void StringDictionary::write(ostream& out, const string& s) {
+  auto it = codes.find(s);
+  if (it != codes.end()) {
+    writeVarint(out, it->second);
+    return;
+  }
+
+  if (codes.size() < MaxEntries) {
+    codes.insert(make_pair(s, uint64_t(codes.size() + 2)));
+    writeVarint(out, NewEntry);
+  }
+  else
+    writeVarint(out, Literal);
+  writeBytes(out, s);
+}
+
+bool StringDictionary::read(istream& in, string& s) {
+  uint64_t code;
+  if (!readVarint(in, code))
+    return false;
+
+  if (code > NewEntry) {
+    if (code - 2 >= entries.size())
+      return false;
+    s = entries[code - 2];
+    return true;
+  }
+
+  if (!readBytes(in, s))
+    return false;
+  if (code == NewEntry)
+    entries.push_back(s);
+  return true;
+}
+
+
+// ValueCodec<int>
+
+/*
+* Complexity: O(1) amortised
+*/
+void ValueCodec<int>::write(ostream& out, size_t column, int val) {
+  if (column >= last.size())
+    last.resize(column + 1, 0);
+
+  writeVarint(out, zigzag(val - last[column]));
+  last[column] = val;
+}
+
+bool ValueCodec<int>::read(istream& in, size_t column, int& val) {
+  uint64_t delta;
+  if (!readVarint(in, delta))
+    return false;
+
+  if (column >= last.size())
+    last.resize(column + 1, 0);
+
+  long long decoded = last[column] + unzigzag(delta);
+  if (decoded < INT_MIN || decoded > INT_MAX)
+    return false;
+
+  val = last[column] = decoded;
+  return true;
+}
+
+
+// ValueCodec<Fraction>
+
+/*
+* Complexity: O(1)
+*/
+void ValueCodec<Fraction>::write(ostream& out, size_t, const Fraction& val) {
+  writeVarint(out, zigzag(val.Numerator()));
+  writeVarint(out, uint64_t(unsigned(val.Denominator())));
+}
+
+bool ValueCodec<Fraction>::read(istream& in, size_t, Fraction& val) {
+  uint64_t numerator, denominator;
+  if (!readVarint(in, numerator) || !readVarint(in, denominator))
+    return false;
+
+  //A denominator of 0 can only come from a corrupt stream
+  long long n = unzigzag(numerator);
+  if (n < INT_MIN || n > INT_MAX || denominator == 0 || denominator > INT_MAX)
+    return false;
+
+  val = Fraction(int(n), int(denominator));
+  return true;
+}
+
+
+// ValueCodec<TypedValue>
+
+/*
+* Complexity: that of the codec of the value's type
+*/
+void ValueCodec<TypedValue>::write(ostream& out, size_t column, const TypedValue& val) {
+  writeVarint(out, val.type());
+  switch (val.type()) {
+    case IntValue:
+      ints.write(out, column, val.numerator());
+      break;
+    case FractionValue:
+      fractions.write(out, column, val.fractionValue());
+      break;
+    case StringValue:
+      strings.write(out, column, val.stringValue());
+      break;
+  }
+}
+
+bool ValueCodec<TypedValue>::read(istream& in, size_t column, TypedValue& val) {
+  uint64_t type;
+  if (!readVarint(in, type))
+    return false;
+
+  switch (type) {
+    case IntValue: {
+      int n;
+      if (!ints.read(in, column, n))
+        return false;
+      val = TypedValue(n);
+      return true;
+    }
+    case FractionValue: {
+      Fraction f;
+      if (!fractions.read(in, column, f))
+        return false;
+      val = TypedValue(f);
+      return true;
+    }
+    case StringValue: {
+      string s;
+      if (!strings.read(in, column, s))
+        return false;
+      val = TypedValue(s);
+      return true;
+    }
+  }
+  return false;
+}
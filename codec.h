@@ -0,0 +1,181 @@
+/**
+*  Compact binary record format, read and written by Database in a single streaming pass.
+*
+*  A stream starts with a magic number followed by the records one after another,
+*  each as its number of fields then the attribute and value of every field.
+*  Attribute names are dictionary encoded: a name is written in full the first time
+*  it is seen and by its code afterwards. Values are encoded by ValueCodec, ints as
+*  the difference from the previous value of the same attribute, strings through a
+*  second dictionary and Fractions as numerator and denominator. Values of a typed
+*  database are written as their type followed by the value as that type writes it,
+*  so the ints of an attribute are still delta encoded. Both sides grow the
+*  dictionaries as they go, so no dictionary is stored separately. Every number is
+*  written as a LEB128 varint, signed ones zigzag encoded first.
+*
+*  Author: Mohammad Ghasembeigi
+*
+*/
+
+#ifndef CODEC_H
+#define CODEC_H
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+using namespace std;
+
+#include "attribute.h"
+#include "fraction.h"
+#include "typedvalue.h"
+
+//Records are only used by the templates below, so record.h is included by their users
+template <class value> class Record;
+template <class value> string valueText(const value& val);
+
+//Magic number every stream starts with, reading it returns false for any other stream
+void writeCodecHeader(ostream& out);
+bool readCodecHeader(istream& in);
+
+//Varint primitives, reads return false at the end of the stream or on a malformed number
+void writeVarint(ostream& out, uint64_t v);
+bool readVarint(istream& in, uint64_t& v);
+void writeBytes(ostream& out, const string& s);
+bool readBytes(istream& in, string& s);
+
+//Map signed numbers to unsigned so small magnitudes of either sign stay short
+inline uint64_t zigzag(long long v) { return (uint64_t(v) << 1) ^ uint64_t(v >> 63); }
+inline long long unzigzag(uint64_t v) { return (long long)(v >> 1) ^ -(long long)(v & 1); }
+
+/* StringDictionary
+* ----------------
+* Strings seen before are written as their code. New strings are written in full and
+* given the next code until the dictionary is full, after which they stay literals.
+* A dictionary is used for either writing or reading, never both.
+*/
+class StringDictionary {
+public:
+  //Default constructor
+  StringDictionary() : codes(unordered_map<string, uint64_t>()), entries(vector<string>()) {}
+
+  static const size_t MaxEntries = 1 << 16;
+
+  //Member functions
+  void write(ostream& out, const string& s);
+  bool read(istream& in, string& s);
+
+  //Default Destructor
+  ~StringDictionary() {};
+
+private:
+  //Codes 0 and 1 announce a literal that is not or is added, code c > 1 is entry c - 2
+  static const uint64_t Literal = 0;
+  static const uint64_t NewEntry = 1;
+
+  unordered_map<string, uint64_t> codes;  //writing
+  vector<string> entries;                 //reading
+
+};
+
+/* ValueCodec
+* ----------
+* Encoding of one value, specialised for each value type. column identifies the attribute
+* so codecs may keep state per attribute. The primary template stores the text of values
+* in a dictionary and is used for any value type without a specialisation.
+*/
+template <class value>
+class ValueCodec {
+public:
+  void write(ostream& out, size_t column, const value& val);
+  bool read(istream& in, size_t column, value& val);
+
+private:
+  StringDictionary texts;
+};
+
+//Ints are stored as the difference from the previous int of the same attribute
+template <>
+class ValueCodec<int> {
+public:
+  void write(ostream& out, size_t column, int val);
+  bool read(istream& in, size_t column, int& val);
+
+private:
+  vector<long long> last;  //previous value per column
+};
+
+template <>
+class ValueCodec<string> {
+public:
+  inline void write(ostream& out, size_t, const string& val) { dictionary.write(out, val); }
+  inline bool read(istream& in, size_t, string& val) { return dictionary.read(in, val); }
+
+private:
+  StringDictionary dictionary;
+};
+
+//Fractions are kept reduced with a positive denominator, so it is stored unsigned
+template <>
+class ValueCodec<Fraction> {
+public:
+  void write(ostream& out, size_t column, const Fraction& val);
+  bool read(istream& in, size_t column, Fraction& val);
+};
+
+
+//Typed values are written as their type, then by the codec of that type
+template <>
+class ValueCodec<TypedValue> {
+public:
+  void write(ostream& out, size_t column, const TypedValue& val);
+  bool read(istream& in, size_t column, TypedValue& val);
+
+private:
+  ValueCodec<int> ints;
+  ValueCodec<Fraction> fractions;
+  ValueCodec<string> strings;
+};
+
+
+template <class value>
+class RecordEncoder {
+public:
+  //Default constructor
+  RecordEncoder<value>() : attributes(unordered_map<Attribute, uint64_t>()), values() {}
+
+  //Member functions
+  void write(ostream& out, const Record<value>& r);
+
+  //Default Destructor
+  ~RecordEncoder() {};
+
+private:
+  unordered_map<Attribute, uint64_t> attributes;  //code of every attribute written so far
+  ValueCodec<value> values;
+
+};
+
+template <class value>
+class RecordDecoder {
+public:
+  //Default constructor
+  RecordDecoder<value>() : attributes(vector<Attribute>()), values() {}
+
+  //Member functions
+  bool read(istream& in, Record<value>& r);
+
+  //Default Destructor
+  ~RecordDecoder() {};
+
+private:
+  vector<Attribute> attributes;  //attribute of every code read so far
+  ValueCodec<value> values;
+
+};
+
+#include "codec.tem"
+
+#endif
@@ -10,33 +10,364 @@
 
 // Your database class definition goes here
 #include "record.h"
+#include "trigram.h"
+#include "aggregate.h"
+#include "mappedfile.h"
+#include "pagedstore.h"
+#include "zonemap.h"
+#include "querycache.h"
+#include "codec.h"
+#include "boundedqueue.h"
+#include "sketch.h"
+#include "attributetypes.h"
+
+#include <map>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <sstream>
+#include <functional>
+
+/* DBWriteOptions
+* --------------
+* Describes the order, amount and fields of records produced by write.
+* An empty orderBy keeps insertion order, a limit of 0 means no limit and
+* an empty fields list writes every field. The first offset records that
+* would be written are skipped. from resumes where an earlier write stopped,
+* it takes the position that write reported through next.
+* Records are ordered by their smallest value of orderBy when ascending and
+* by their largest when descending, records without the attribute come last.
+*/
+struct DBWriteOptions {
+  DBWriteOptions() : orderBy(), descending(false), limit(0), offset(0), from(0), fields() {}
+
+  string orderBy;
+  bool descending;
+  size_t limit;
+  size_t offset;
+  size_t from;
+  vector<string> fields;
+};
+
+/* DBGroup
+* -------
+* One group produced by groupBy: the key value, how many records carry it
+* and the aggregate of the grouped attribute over those records.
+*/
+enum DBGroupOrder { ByKey, ByCount, BySum, ByMin, ByMax };
+
+template <class value>
+struct DBGroup {
+  DBGroup() : key(), records(0), values() {}
+
+  value key;
+  size_t records;
+  Aggregate<value> values;
+};
+
+/* DBEstimate
+* ----------
+* How many records a select would change, estimated from the sample of records a database keeps.
+* Add can only change unselected records and remove and refine selected ones: sampled is the number
+* of sampled records of that kind and hits the number of those the select would change. records is
+* the estimate and low to high its 95% confidence interval, all three are exact when every record
+* of that kind is sampled. Without any sampled records the interval covers every record of the kind.
+*/
+struct DBEstimate {
+  DBEstimate() : sampled(0), hits(0), records(0), low(0), high(0) {}
+
+  size_t sampled;
+  size_t hits;
+  double records;
+  double low;
+  double high;
+};
+
+/* DBMemory
+* --------
+* Approximate bytes of memory used by a database, per structure. records covers the records and
+* their fields, values the text of string values kept outside of them. Lazily read records only
+* count once parsed, the text they are read from is in the file mapping counted by mapped, which
+* the system reads in and drops as needed. Attribute names are shared by every database. Neither
+* of those last two is part of the total, which is what the memory budget limits.
+*/
+struct DBMemory {
+  DBMemory() : records(0), values(0), selection(0), zones(0), sample(0), sketches(0), trigrams(0),
+               indexes(0), cache(0), pages(0), mapped(0), names(0) {}
+
+  size_t records;
+  size_t values;
+  size_t selection;
+  size_t zones;
+  size_t sample;
+  size_t sketches;
+  size_t trigrams;
+  size_t indexes;
+  size_t cache;
+  size_t pages;
+  size_t mapped;
+  size_t names;
+
+  inline size_t total() const {
+    return records + values + selection + zones + sample + sketches + trigrams + indexes + cache + pages;
+  }
+};
+
+/* DBProgress
+* ----------
+* Shared between a long running operation and whoever started it, usually on another
+* thread. The operation publishes how many records it has processed and checks for
+* cancel at regular points, stopping early when it is set. A cancelled select leaves
+* the selection unchanged and a cancelled read leaves the database with no records.
+*/
+struct DBProgress {
+  DBProgress() : processed(0), cancel(false) {}
+
+  atomic<size_t> processed;
+  atomic<bool> cancel;
+};
 
 template <class value>
 class Database {
 public:
   //Default constructor
-  Database<value>() : records(list<Record<value>>()), numSelected_(0) {}
+  Database<value>() : records(vector<Record<value>>()), selected(vector<bool>()), numSelected_(0), source(), pages(), zonesValid(false), version(++versions), queryCache(),
+                      sample(SampleSize), sketchesValid(false), sketches(unordered_map<Attribute, HyperLogLog>()),
+                      budget(0), budgetExceeded(false), recordBytes(0), valueTextBytes(0), progress(NULL), useTrigrams(true), trigramsValid(false), sortedIndexes(map<string, SortedIndex>()),
+                      types() {}
+
+  //Databases are moved rather than copied, a background read moves the records it loaded into place
+  Database<value>(Database<value>&&) = default;
+  Database<value>& operator=(Database<value>&&) = default;
 
   //Member functions
 
   //Complexity of inlines: O(1)
-  inline int numRecords() const { return records.size(); }
+  inline int numRecords() const { return pages ? pages->size() : records.size(); }
   inline int numSelected() const { return numSelected_; }
+  inline bool isPaged() const { return pages != NULL; }
+  inline unsigned long recordsVersion() const { return version; }
 
-  void write(ostream& out, DBScope scope) const;
+  //Paged databases ignore options.orderBy and always write in insertion order
+  //next receives where the following records start, numRecords() when none are left
+  int write(ostream& out, DBScope scope, const DBWriteOptions& options = DBWriteOptions(), size_t* next = NULL) const;
   void read(istream& in);
-  void deleteRecords(DBScope scope);
+
+  //Lazy and paged reads keep records as text, so they are refused by typed databases
+  bool readLazy(const string& filename);
+  bool readPaged(istream& in, size_t budgetBytes);
+
+  //Add the records of a stream after the existing ones, which keep their positions and selection.
+  //Secondary structures are extended with the new records rather than rebuilt
+  int append(istream& in);
+
+  //Binary format of codec.h, much smaller and faster to load than text. readCompressed fails
+  //on a stream in another format, leaving the records, or on a truncated one, leaving none
+  int writeCompressed(ostream& out, DBScope scope) const;
+  bool readCompressed(istream& in);
+  bool deleteRecords(DBScope scope);
+  int update(const string& attr, const value& val);
   void selectAll();
   void deselectAll();
   void select(DBSelectOperation selOp, const string& attr, DBQueryOperator op, const value& val);
 
+  //Enable or disable the trigram index used to narrow "^" queries
+  void setTrigramIndex(bool enabled);
+
+  //Results of repeated select criteria are cached until the records change
+  void setQueryCacheBudget(size_t budgetBytes);
+  inline void clearQueryCache() { queryCache.clear(); }
+  inline const QueryCache& cache() const { return queryCache; }
+
+  //Approximate memory used by every structure, records are visited to count them exactly
+  DBMemory memoryUsage() const;
+
+  //Keep the memory used within budgetBytes, 0 for no budget. Optional structures are dropped while
+  //over it, and reads and appends stop once the records alone would not fit. A read stopped by the
+  //budget leaves no records, exceededBudget tells whether the last read or append was stopped, or
+  //whether the records of a lazy read parsed by the last select no longer fit
+  void setMemoryBudget(size_t budgetBytes);
+  inline size_t memoryBudget() const { return budget; }
+  inline bool exceededBudget() const { return budgetExceeded; }
+
+  //Progress of the reads and selects that follow is published to and cancelled through progress, NULL for none
+  inline void setProgress(DBProgress* p) { progress = p; }
+
+  //Estimate of the records a select would change, answered from a sample of SampleSize records
+  //without touching the records themselves
+  DBEstimate estimateSelect(DBSelectOperation selOp, const string& attr, DBQueryOperator op, const value& val) const;
+
+  //Approximate number of distinct values of attr ("*" for any attribute) over every record,
+  //typically within HyperLogLog::standardError() of the true number
+  double distinctValues(const string& attr);
+
+  //Count, min, max and sum of every value of attr ("*" for any attribute) in one pass
+  Aggregate<value> aggregate(const string& attr, DBScope scope) const;
+
+  //Per key group record counts and aggregates of valueAttr (may be empty), sorted as requested
+  vector<DBGroup<value>> groupBy(const string& keyAttr, const string& valueAttr, DBScope scope,
+                                 DBGroupOrder order = ByKey, bool descending = false) const;
+
+  //Write every pairing of a record in scope with a record of other sharing a value of attr and otherAttr
+  int join(ostream& out, const string& attr, DBScope scope,
+           const Database<value>& other, const string& otherAttr, DBScope otherScope) const;
+
+  //Maintain a sorted index on attr, used by write to produce ordered output without sorting
+  void createIndex(const string& attr);
+  bool dropIndex(const string& attr);
+  inline bool hasIndex(const string& attr) const { return sortedIndexes.count(attr) > 0; }
+
+  //Fix the type of the values of attr in a typed database, converting those that can be written as it
+  void declareType(const string& attr, ValueType type);
+  inline const AttributeTypes<value>& attributeTypes() const { return types; }
+
+  //Take the budgets, index and trigram settings and declared types of other, keeping the records
+  void copySettings(const Database<value>& other);
+
   //Default Destructor
   ~Database() {};
 
 private:
-  list<Record<value>> records;
+  //Scans over at least this many records are split across threads
+  static const size_t ParallelThreshold = 1 << 16;
+
+  //Probe side positions a thread joins at a time, the output of a piece is written as a whole
+  static const size_t JoinPieceSize = 1 << 12;
+
+  //Size of the blocks read pulls from its stream
+  static const size_t ReadBlockSize = 1 << 20;
+
+  //Records between the points where long operations publish progress and check for cancel
+  static const size_t ProgressInterval = 1 << 12;
+
+  //Records kept in the sample estimates are made from
+  static const size_t SampleSize = 1 << 10;
+
+  //Records are kept contiguously so their position can be used as an id by secondary structures
+  //The selection is kept alongside as one bit per record position
+  vector<Record<value>> records;
+  vector<bool> selected;
   int numSelected_;
 
+  //File mapping lazily read records point into, kept alive as long as they are
+  shared_ptr<MappedFile> source;
+
+  //Disk backed storage used instead of records by paged databases, which only support sequential scans
+  shared_ptr<PagedStore> pages;
+
+  //Per block value ranges used by select to skip blocks that can not match. Maintained as records
+  //are read and deleted, lazily read records are only summarised on the first select that needs them
+  bool zonesValid;
+  ZoneMap<value> zones;
+
+  //Changed whenever records are read, appended or deleted, cached select results are only valid for one version.
+  //Versions are drawn from versions so no two databases share one, even when one is moved into the other's place
+  unsigned long version;
+  static atomic<unsigned long> versions;
+  QueryCache queryCache;
+
+  //Uniform sample of the records, kept as copies so estimates do not depend on how records are stored.
+  //Taken as records are read, copies are refreshed on update and the sample is taken again on delete
+  struct Sampled {
+    Sampled() : id(0), record() {}
+
+    unsigned id;
+    Record<value> record;
+  };
+  ReservoirSample<Sampled> sample;
+
+  //HyperLogLog sketch of the values of every attribute. Built as records are read, or on the first
+  //distinct after a lazy read, and dropped when an update or delete may have removed values
+  bool sketchesValid;
+  unordered_map<Attribute, HyperLogLog> sketches;
+
+  //Memory budget, 0 for none, and whether it stopped the last read or append or the last select exceeded it
+  size_t budget;
+  bool budgetExceeded;
+
+  //Memory held by records outside of the records vector, split as DBMemory does. Kept up to date as
+  //records are read, appended, updated and deleted, lazily read records are counted once memoryUsage
+  //finds them parsed
+  mutable size_t recordBytes;
+  mutable size_t valueTextBytes;
+
+  //Progress of the current operation, owned by whoever set it
+  DBProgress* progress;
+
+  //Trigram index over the text of every value, built lazily on the first "^" query
+  //and invalidated whenever record positions change. Not used by paged databases
+  bool useTrigrams;
+  bool trigramsValid;
+  TrigramIndex trigrams;
+
+  //Sorted (value, record position) pairs per indexed attribute, rebuilt lazily after positions change
+  //Entries of appended records are kept apart and merged in the next time the index is used
+  //Not used by paged databases
+  struct SortedIndex {
+    SortedIndex() : valid(false), entries(vector<pair<value, unsigned>>()), appended(vector<pair<value, unsigned>>()), textBytes(0) {}
+
+    bool valid;
+    vector<pair<value, unsigned>> entries;
+    vector<pair<value, unsigned>> appended;
+    size_t textBytes;   //memory held by the text of string values in entries and appended
+  };
+  mutable map<string, SortedIndex> sortedIndexes;
+
+  //Declared and inferred types of the attributes of a typed database, nothing for other databases.
+  //Values are converted to the type of their attribute once a read, append or update has finished
+  AttributeTypes<value> types;
+
+  //Order of sorted index entries: by value, equal values in insertion order
+  static inline bool indexOrder(const pair<value, unsigned>& a, const pair<value, unsigned>& b) {
+    return a.first < b.first || (!(b.first < a.first) && a.second < b.second);
+  }
+
+  //One hash partition of the build side of a join, mapping keys to the positions of the records
+  //holding them and those positions to the text of the record
+  struct JoinPartition {
+    JoinPartition() : ids(unordered_map<value, vector<unsigned>>()), bodies(unordered_map<unsigned, string>()) {}
+
+    unordered_map<value, vector<unsigned>> ids;
+    unordered_map<unsigned, string> bodies;
+  };
+
+  //Private helper functions
+  template <class Visitor> void scan(DBScope scope, Visitor visit, const vector<bool>* blocks = NULL, size_t from = 0) const;
+  void clearRecords();
+  void abandonRead();
+  void countRecords() const;
+  void countParsed(const Record<value>& r, bool wasParsed) const;
+  void applyTypes();
+  bool reportProgress(size_t processed) const;
+  bool stopReading(size_t processed);
+  DBMemory currentUsage() const;
+  bool withinBudget();
+  inline bool cancelled() const { return progress != NULL && progress->cancel; }
+  void matchQuery(const string& attr, DBQueryOperator op, const value& val, DBScope scope, vector<bool>& matches);
+  void updateSelection(unsigned id, DBSelectOperation selOp, bool matched);
+  void buildZones();
+  void summarise(unsigned id, const Record<value>& r);
+  void sampleRecord(unsigned id, const Record<value>& r);
+  void buildSample();
+  void sketchRecord(const Record<value>& r);
+  void buildSketches();
+  void buildTrigrams();
+  const SortedIndex& sortedIndex(const string& attr) const;
+  void orderedIds(DBScope scope, const DBWriteOptions& options, vector<unsigned>& ids) const;
+  void orderedIdsFromIndex(DBScope scope, const DBWriteOptions& options, vector<unsigned>& ids) const;
+  void groupRange(size_t begin, size_t end, Attribute keyAttr, Attribute valueAttr, DBScope scope,
+                  unordered_map<value, DBGroup<value>>& groups) const;
+  static void groupRecord(const Record<value>& r, Attribute keyAttr, Attribute valueAttr,
+                          unordered_map<value, DBGroup<value>>& groups);
+  static string recordBody(const Record<value>& r);
+  static void addToJoin(unsigned id, const Record<value>& r, Attribute attr, vector<JoinPartition>& tables);
+  static void mergeJoin(JoinPartition& into, JoinPartition& from);
+  static int probeJoin(ostream& out, const Record<value>& r, Attribute attr,
+                       const vector<JoinPartition>& partitions, bool buildFirst);
+  void invalidateIndexes();
+
 };
 
 #include "database.tem"
@@ -0,0 +1,340 @@
+/**
+*  Behaviour checks of Database on small hand written inputs.
+*
+*  Each check builds databases from record text and compares what they
+*  produce with results worked out by hand, covering the results that
+*  are easy to get wrong: "^" matches with and without the trigram index,
+*  order by and limit with ties, exact Fraction sums, join output, sorted
+*  index upkeep across update and append, compressed round trips, paging
+*  with next and the order the memory budget drops structures in.
+*
+*  Usage: dbcheck
+*  Return: 0 if every check passes, 1 otherwise
+*
+*  Author: Mohammad Ghasembeigi
+*
+*/
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "database.h"
+
+namespace {
+  int failures = 0;
+
+  void expect(bool ok, const string& what) {
+    if (!ok) {
+      cout << "ERROR: " << what << "\n";
+      ++failures;
+    }
+  }
+
+  void expectText(const string& got, const string& expected, const string& what) {
+    if (got != expected) {
+      cout << "ERROR: " << what << ", expected:\n" << expected << "got:\n" << got;
+      ++failures;
+    }
+  }
+
+  template <class value>
+  void load(Database<value>& db, const string& text) {
+    istringstream in(text);
+    db.read(in);
+  }
+
+  template <class value>
+  string written(const Database<value>& db, DBScope scope, const DBWriteOptions& options = DBWriteOptions(),
+                 size_t* next = NULL) {
+    ostringstream out;
+    db.write(out, scope, options, next);
+    return out.str();
+  }
+
+  //Values of attr in the order write produces the records, separated by spaces
+  template <class value>
+  string orderOf(const Database<value>& db, DBWriteOptions options, const string& attr) {
+    options.fields.assign(1, attr);
+    istringstream in(written(db, AllRecords, options));
+    string line, order;
+    while (getline(in, line)) {
+      size_t equals = line.find(" = ");
+      if (equals != string::npos)
+        order += (order.empty() ? "" : " ") + line.substr(equals + 3);
+    }
+    return order;
+  }
+
+  DBWriteOptions ordered(const string& attr, bool descending, size_t limit) {
+    DBWriteOptions options;
+    options.orderBy = attr;
+    options.descending = descending;
+    options.limit = limit;
+    return options;
+  }
+
+  const string Names =
+    "{\n  name = example\n  id = 1\n}\n"
+    "{\n  name = sample text\n  id = 2\n}\n"
+    "{\n  name = exam\n  id = 3\n}\n"
+    "{\n  name = apple\n  id = 4\n}\n"
+    "{\n  title = example\n  id = 5\n}\n";
+
+  //Substring matches, narrowed by the trigram index for patterns of at least MinPatternLength
+  void checkContains() {
+    for (int trigrams = 0; trigrams < 2; ++trigrams) {
+      Database<string> db;
+      db.setTrigramIndex(trigrams == 1);
+      load(db, Names);
+      string how = trigrams ? " with the trigram index" : " without the trigram index";
+
+      db.select(Add, "name", Contains, "xam");
+      expect(db.numSelected() == 2, "name ^ xam should match example and exam" + how);
+
+      db.deselectAll();
+      db.select(Add, "name", Contains, "ex");
+      expect(db.numSelected() == 3, "name ^ ex should match example, sample text and exam" + how);
+
+      db.deselectAll();
+      db.select(Add, "*", Contains, "example");
+      expect(db.numSelected() == 2, "* ^ example should match name and title" + how);
+
+      db.deselectAll();
+      db.select(Add, "name", Contains, "ample");
+      db.select(Refine, "name", Contains, "text");
+      expect(db.numSelected() == 1, "name ^ ample refined by ^ text should leave sample text" + how);
+
+      db.deselectAll();
+      db.select(Add, "name", Contains, "zzz");
+      expect(db.numSelected() == 0, "name ^ zzz should match nothing" + how);
+    }
+  }
+
+  const string Keys =
+    "{\n  id = 0\n  k = 3\n}\n"
+    "{\n  id = 1\n  k = 1\n}\n"
+    "{\n  id = 2\n  k = 3\n}\n"
+    "{\n  id = 3\n  k = 2\n}\n"
+    "{\n  id = 4\n  k = 1\n}\n"
+    "{\n  id = 5\n}\n"
+    "{\n  id = 6\n  k = 9\n  k = 0\n}\n";
+
+  //Ties keep insertion order in both directions, records without the attribute come last
+  void checkOrder() {
+    for (int indexed = 0; indexed < 2; ++indexed) {
+      Database<int> db;
+      if (indexed)
+        db.createIndex("k");
+      load(db, Keys);
+      string how = indexed ? " with a sorted index" : " without a sorted index";
+
+      expectText(orderOf(db, ordered("k", false, 0), "id"), "6 1 4 3 0 2 5", "order by k" + how);
+      expectText(orderOf(db, ordered("k", false, 2), "id"), "6 1", "order by k limit 2" + how);
+      expectText(orderOf(db, ordered("k", false, 3), "id"), "6 1 4", "order by k limit 3" + how);
+      expectText(orderOf(db, ordered("k", true, 0), "id"), "6 0 2 3 1 4 5", "order by k descending" + how);
+      expectText(orderOf(db, ordered("k", true, 2), "id"), "6 0", "order by k descending limit 2" + how);
+
+      DBWriteOptions offset = ordered("k", false, 2);
+      offset.offset = 2;
+      expectText(orderOf(db, offset, "id"), "4 3", "order by k limit 2 offset 2" + how);
+    }
+  }
+
+  //Fraction sums are exact, whatever order the values are added in
+  void checkFractionSum() {
+    Database<Fraction> db;
+    load(db, "{\n  x = 1/3\n}\n{\n  x = 1/3\n  x = 1/6\n}\n{\n  x = 1/3\n}\n{\n  x = -1/6\n}\n{\n  y = 5\n}\n");
+
+    Aggregate<Fraction> total = db.aggregate("x", AllRecords);
+    ostringstream sum;
+    total.sum().write(sum);
+    expect(total.count() == 5, "x should have 5 values");
+    expectText(sum.str(), "1", "sum of x");
+
+    Database<TypedValue> typed;
+    load(typed, "{\n  x = 1/3\n}\n{\n  x = 2/3\n}\n{\n  x = 2\n}\n{\n  y = many\n}\n");
+    ostringstream typedSum;
+    typed.aggregate("*", AllRecords).sum().write(typedSum);
+    expectText(typedSum.str(), "3", "typed sum of every attribute, leaving out strings");
+  }
+
+  //Pairs are written in probe side order, each build record in build side order
+  void checkJoin() {
+    Database<int> left, right;
+    load(left, "{\n  id = 1\n  k = 1\n}\n{\n  id = 2\n  k = 2\n}\n{\n  id = 3\n  k = 1\n}\n");
+    load(right, "{\n  j = 1\n  x = 10\n}\n{\n  j = 3\n  x = 30\n}\n{\n  j = 1\n  j = 2\n  x = 11\n}\n");
+
+    ostringstream out;
+    int joined = left.join(out, "k", AllRecords, right, "j", AllRecords);
+    expect(joined == 5, "join of k and j should write 5 records");
+    expectText(out.str(),
+      "{\n  id = 1\n  k = 1\n  j = 1\n  x = 10\n}\n"
+      "{\n  id = 3\n  k = 1\n  j = 1\n  x = 10\n}\n"
+      "{\n  id = 1\n  k = 1\n  j = 1\n  j = 2\n  x = 11\n}\n"
+      "{\n  id = 2\n  k = 2\n  j = 1\n  j = 2\n  x = 11\n}\n"
+      "{\n  id = 3\n  k = 1\n  j = 1\n  j = 2\n  x = 11\n}\n", "join of k and j");
+
+    left.select(Add, "id", GreaterThan, 1);
+    ostringstream selectedOut;
+    joined = left.join(selectedOut, "k", SelectedRecords, right, "j", AllRecords);
+    expect(joined == 3, "join of selected k and j should write 3 records");
+  }
+
+  //Ordered output through a sorted index matches a sort of the same records after updates and appends
+  void checkIndexUpkeep() {
+    Database<int> indexed, sorted;
+    indexed.createIndex("k");
+    load(indexed, Keys);
+    load(sorted, Keys);
+    orderOf(indexed, ordered("k", false, 0), "id");  //builds the index
+
+    for (int step = 0; step < 3; ++step) {
+      Database<int>* dbs[] = { &indexed, &sorted };
+      for (auto db : dbs) {
+        if (step == 0) {
+          db->select(Add, "k", Equal, 3);
+          db->update("k", 2);
+        }
+        else if (step == 1) {
+          istringstream in("{\n  id = 7\n  k = 2\n}\n{\n  id = 8\n}\n");
+          db->append(in);
+        }
+        else {
+          db->deselectAll();
+          db->select(Add, "id", GreaterThan, 5);
+          db->update("k", -1);
+        }
+      }
+
+      for (int descending = 0; descending < 2; ++descending) {
+        for (size_t limit = 0; limit < 4; limit += 3) {
+          DBWriteOptions options = ordered("k", descending == 1, limit);
+          expectText(orderOf(indexed, options, "id"), orderOf(sorted, options, "id"),
+                     "indexed order by k after step " + to_string(step));
+        }
+      }
+    }
+  }
+
+  //Records read back from the compressed format write the same text
+  template <class value>
+  void checkRoundTrip(const string& name, const string& text) {
+    Database<value> db, loaded;
+    load(db, text);
+
+    stringstream compressed;
+    expect(db.writeCompressed(compressed, AllRecords) == db.numRecords(), name + " writeCompressed should write every record");
+    expect(loaded.readCompressed(compressed), name + " readCompressed should accept what writeCompressed wrote");
+    expectText(written(loaded, AllRecords), written(db, AllRecords), name + " compressed round trip");
+
+    //Cut inside the last record
+    string bytes = compressed.str();
+    istringstream truncated(bytes.substr(0, bytes.length() - 1));
+    expect(!loaded.readCompressed(truncated) && loaded.numRecords() == 0, name + " truncated stream should fail and leave no records");
+
+    istringstream text2(text);
+    expect(!loaded.readCompressed(text2), name + " text should not be read as compressed");
+  }
+
+  void checkCodec() {
+    checkRoundTrip<int>("int", Keys + "{\n  id = -2147483648\n  k = 2147483647\n}\n");
+    checkRoundTrip<string>("string", Names + "{\n  name = \n  empty = \n}\n");
+    checkRoundTrip<Fraction>("Fraction", "{\n  x = 1/3\n  x = -7/2\n}\n{\n  x = 0\n  y = 5\n}\n");
+    checkRoundTrip<TypedValue>("typed", "{\n  x = 1/3\n  y = text\n}\n{\n  x = 4\n  y = 12\n}\n");
+  }
+
+  //Pages continued with next cover every record once, in order
+  void checkPaging() {
+    Database<int> db;
+    load(db, Keys);
+
+    DBWriteOptions options;
+    for (int order = 0; order < 2; ++order) {
+      if (order == 1)
+        options = ordered("k", false, 0);
+      string all = written(db, AllRecords, options), pages;
+
+      options.limit = 3;
+      size_t next = 0;
+      int numPages = 0;
+      do {
+        options.from = next;
+        pages += written(db, AllRecords, options, &next);
+        ++numPages;
+      } while (next < size_t(db.numRecords()) && numPages < 10);
+
+      expectText(pages, all, order ? "ordered pages" : "pages");
+      expect(numPages == 3, "7 records should take 3 pages of 3");
+    }
+
+    db.select(Add, "k", LessThan, 3);
+    DBWriteOptions selected;
+    selected.limit = 2;
+    size_t next = 0;
+    string first = written(db, SelectedRecords, selected, &next);
+    selected.from = next;
+    string second = written(db, SelectedRecords, selected, &next);
+    expectText(first + second, written(db, SelectedRecords), "pages of selected records");
+    expect(next == size_t(db.numRecords()), "next should be past the last record after the last page");
+  }
+
+  //Structures are dropped cheapest to rebuild first: cache, indexes, sketches, then zones
+  void checkBudget() {
+    string text;
+    for (int i = 0; i < 2000; ++i) {
+      text += "{\n  id = " + to_string(i) + "\n  k = " + to_string(i % 37) + "\n}\n";
+    }
+
+    Database<int> db;
+    load(db, text);
+    db.select(Add, "id", Contains, 123);
+    db.select(Add, "k", Equal, 5);
+    db.distinctValues("k");
+
+    DBMemory before = db.memoryUsage();
+    expect(before.cache > 0 && before.trigrams > 0 && before.sketches > 0 && before.zones > 0,
+           "cache, trigrams, sketches and zones should all be in use");
+
+    db.setMemoryBudget(before.total() - 1);
+    DBMemory usage = db.memoryUsage();
+    expect(usage.cache == 0 && usage.trigrams > 0 && usage.sketches > 0 && usage.zones > 0, "the cache should be dropped first");
+
+    db.setMemoryBudget(usage.total() - 1);
+    usage = db.memoryUsage();
+    expect(usage.trigrams == 0 && usage.sketches > 0 && usage.zones > 0, "indexes should be dropped next");
+
+    db.setMemoryBudget(usage.total() - 1);
+    usage = db.memoryUsage();
+    expect(usage.sketches == 0 && usage.zones > 0, "sketches should be dropped before zones");
+
+    db.setMemoryBudget(usage.total() - 1);
+    usage = db.memoryUsage();
+    expect(usage.zones == 0 && db.numRecords() == 2000, "zones should be dropped last, keeping the records");
+
+    //A read that does not fit keeps nothing, and the next read that fits is not reported as over
+    db.setMemoryBudget(usage.records / 2);
+    load(db, text);
+    expect(db.exceededBudget() && db.numRecords() == 0, "a read over the budget should keep no records");
+    db.setMemoryBudget(0);
+    load(db, Keys);
+    expect(!db.exceededBudget() && db.numRecords() == 7, "a read within the budget should not be reported as over it");
+  }
+}
+
+int main() {
+  checkContains();
+  checkOrder();
+  checkFractionSum();
+  checkJoin();
+  checkIndexUpkeep();
+  checkCodec();
+  checkPaging();
+  checkBudget();
+
+  cout << (failures == 0 ? "Every database check passed.\n" : to_string(failures) + " database checks failed.\n");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,190 @@
+/**
+*  Check and benchmark of FixedRecord against Record on the inventory schema.
+*
+*  Records following InventorySchema are generated along with blocks that do not
+*  (a field missing, out of order, repeated or not in the schema), which take the
+*  fallback path. Both record types must write back the same text and match the
+*  same records for every query, after which the time each takes to load and to
+*  scan the records is reported. A file of inventory records may be given instead.
+*
+*  Usage: fixedbench [records | file]
+*  Return: 0 if FixedRecord and Record agree, 1 otherwise
+*
+*  Author: Mohammad Ghasembeigi
+*
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+using namespace std;
+
+#include "fixedrecord.h"
+
+typedef FixedRecord<InventorySchema> InventoryRecord;
+
+namespace {
+  //Seconds taken by f
+  template <class F>
+  double timed(F f) {
+    auto start = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  }
+
+  //Inventory records, every FallbackInterval'th block breaking the schema a different way
+  const size_t FallbackInterval = 97;
+
+  string generate(size_t n, size_t& fallbacks) {
+    ostringstream out;
+    fallbacks = 0;
+    for (size_t i = 0; i < n; ++i) {
+      int stock = i * 7 % 50, cost = i * 13 % 90 + 1;
+      out << "{\n";
+      if (i % FallbackInterval != 0) {
+        out << "  part number = " << i << "\n  number in stock = " << stock
+            << "\n  supplier cost = " << cost << "\n  retail cost = " << cost * 2 << "\n";
+      }
+      else {
+        switch (++fallbacks % 4) {
+        case 0:
+          out << "  part number = " << i << "\n  retail cost = " << cost << "\n";
+          break;
+        case 1:
+          out << "  number in stock = " << stock << "\n  part number = " << i
+              << "\n  supplier cost = " << cost << "\n  retail cost = " << cost << "\n";
+          break;
+        case 2:
+          out << "  part number = " << i << "\n  part number = " << i + 1 << "\n  number in stock = " << stock
+              << "\n  supplier cost = " << cost << "\n  retail cost = " << cost << "\n";
+          break;
+        case 3:
+          out << "  part number = " << i << "\n  number in stock = " << stock << "\n  supplier cost = " << cost
+              << "\n  retail cost = " << cost << "\n  discount = " << cost / 10 << "\n";
+          break;
+        }
+      }
+      out << "}\n";
+    }
+    return out.str();
+  }
+
+  template <class R>
+  void load(const string& text, vector<R>& records) {
+    istringstream in(text);
+    R r;
+    while (in >> r) {
+      records.push_back(std::move(r));
+    }
+  }
+
+  template <class R>
+  string written(const vector<R>& records) {
+    ostringstream out;
+    for (auto it = records.begin(); it != records.end(); ++it) {
+      out << *it << '\n';
+    }
+    return out.str();
+  }
+
+  template <class R>
+  size_t count(const vector<R>& records, const string& attr, DBQueryOperator op, int want) {
+    size_t matched = 0;
+    for (auto it = records.begin(); it != records.end(); ++it) {
+      matched += it->matchesQuery(attr, op, want);
+    }
+    return matched;
+  }
+}
+
+int main(int argc, char* argv[]) {
+  string text;
+  size_t expectedFallbacks = 0;
+  bool generated = argc < 2 || atoi(argv[1]) > 0;
+
+  if (generated)
+    text = generate(argc < 2 ? 200000 : atoi(argv[1]), expectedFallbacks);
+  else {
+    ifstream in(argv[1]);
+    if (!in) {
+      cout << "ERROR: Cannot open file named \"" << argv[1] << "\".\n";
+      return 1;
+    }
+    ostringstream contents;
+    contents << in.rdbuf();
+    text = contents.str();
+  }
+
+  vector<Record<int>> records;
+  vector<InventoryRecord> fixed;
+  double recordLoad = timed([&]() { load(text, records); });
+  double fixedLoad = timed([&]() { load(text, fixed); });
+
+  bool agree = true;
+  if (records.size() != fixed.size()) {
+    cout << "ERROR: Record read " << records.size() << " records, FixedRecord " << fixed.size() << ".\n";
+    return 1;
+  }
+  if (written(records) != written(fixed)) {
+    cout << "ERROR: FixedRecord writes back different text than Record.\n";
+    agree = false;
+  }
+
+  size_t fallbacks = 0;
+  for (auto it = fixed.begin(); it != fixed.end(); ++it) {
+    fallbacks += !it->followsSchema();
+  }
+  if (generated && fallbacks != expectedFallbacks) {
+    cout << "ERROR: " << fallbacks << " records fell back to Record, expected " << expectedFallbacks << ".\n";
+    agree = false;
+  }
+
+  const char* attrs[] = { "part number", "retail cost", "discount", "*" };
+  const DBQueryOperator ops[] = { Equal, NotEqual, LessThan, GreaterThan };
+  for (auto attr : attrs) {
+    for (auto op : ops) {
+      size_t expected = count(records, attr, op, 40), got = count(fixed, attr, op, 40);
+      if (expected != got) {
+        cout << "ERROR: \"" << attr << "\" query " << op << " 40 matched " << got << " records, Record matched " << expected << ".\n";
+        agree = false;
+      }
+    }
+  }
+
+  //Scans of one attribute, by name, by attribute and by position resolved while compiling
+  Attribute retail = AttributeNames::intern("retail cost");
+  size_t byName = 0, byAttribute = 0, byIndex = 0, expected = 0;
+  double recordScan = timed([&]() {
+    for (auto it = records.begin(); it != records.end(); ++it) {
+      expected += it->matchesQuery(retail, GreaterThan, 40);
+    }
+  });
+  double nameScan = timed([&]() { byName = count(fixed, "retail cost", GreaterThan, 40); });
+  double attributeScan = timed([&]() {
+    for (auto it = fixed.begin(); it != fixed.end(); ++it) {
+      byAttribute += it->matchesQuery(retail, GreaterThan, 40);
+    }
+  });
+  double indexScan = timed([&]() {
+    for (auto it = fixed.begin(); it != fixed.end(); ++it) {
+      byIndex += it->matchesQuery<schemaIndex<InventorySchema>("retail cost")>(GreaterThan, 40);
+    }
+  });
+  if (byName != expected || byAttribute != expected || byIndex != expected) {
+    cout << "ERROR: retail cost > 40 matched " << byName << ", " << byAttribute << " and " << byIndex
+         << " records, Record matched " << expected << ".\n";
+    agree = false;
+  }
+
+  cout << records.size() << " records, " << fallbacks << " not following the schema\n";
+  cout << "load:  Record " << recordLoad << "s, FixedRecord " << fixedLoad << "s\n";
+  cout << "scan:  Record " << recordScan << "s, FixedRecord by name " << nameScan << "s, by attribute "
+       << attributeScan << "s, by index " << indexScan << "s\n";
+  cout << (agree ? "FixedRecord agrees with Record.\n" : "FixedRecord does not agree with Record.\n");
+  return agree ? 0 : 1;
+}
@@ -0,0 +1,84 @@
+/**
+*  Record with a schema fixed at compile time.
+*
+*  A FixedRecord stores the values of its schema's attributes as plain fields, one
+*  per attribute, instead of the map of attributes to value lists kept by Record.
+*  Reading parses by position: the i-th line of a block must hold the i-th attribute
+*  of the schema, so names are compared rather than split, trimmed and interned.
+*  Blocks that do not follow the schema exactly (an attribute missing, repeated, out
+*  of order or not in the schema) are kept as an ordinary Record instead, so any
+*  text Record can read is read and written back the same way.
+*
+*  Author: Mohammad Ghasembeigi
+*
+*/
+
+#ifndef FIXEDRECORD_H
+#define FIXEDRECORD_H
+
+#include <iostream>
+#include <string>
+#include <array>
+#include <memory>
+
+using namespace std;
+
+#include "record.h"
+#include "schema.h"
+
+template <class Schema> class FixedRecord;
+template <class Schema> ostream& operator<<(ostream& out, const FixedRecord<Schema>& r);
+template <class Schema> istream& operator>>(istream& in, FixedRecord<Schema>& r);
+
+template <class Schema>
+class FixedRecord {
+public:
+  typedef typename Schema::value value;
+  static const size_t Size = Schema::Size;
+
+  //Default constructor
+  FixedRecord<Schema>() : slots(), dynamic() {}
+
+  //Copies take their own copy of a fallback record
+  FixedRecord<Schema>(const FixedRecord<Schema>& other);
+  FixedRecord<Schema>(FixedRecord<Schema>&&) = default;
+  FixedRecord<Schema>& operator=(const FixedRecord<Schema>& other);
+  FixedRecord<Schema>& operator=(FixedRecord<Schema>&&) = default;
+
+  //Member functions
+
+  //Query matching as Record does, attr may be "*"
+  bool matchesQuery(const string& attr, DBQueryOperator op, const value& want) const;
+  bool matchesQuery(Attribute attr, DBQueryOperator op, const value& want) const;
+
+  //Query matching on the I-th attribute of the schema, resolved while compiling,
+  //for example r.matchesQuery<schemaIndex<InventorySchema>("retail cost")>(GreaterThan, 40)
+  template <size_t I> bool matchesQuery(DBQueryOperator op, const value& want) const;
+
+  //First value of the I-th attribute of the schema, NULL if the record has none
+  template <size_t I> const value* get() const;
+
+  //Complexity of inlines: O(1)
+  inline bool followsSchema() const { return !dynamic; }
+  inline const Record<value>* fallback() const { return dynamic.get(); }
+
+  //Operator overloads
+  friend ostream& operator<<<Schema>(ostream& out, const FixedRecord<Schema>& r);
+  friend istream& operator>><Schema>(istream& in, FixedRecord<Schema>& r);
+
+  //Default Destructor
+  ~FixedRecord() {};
+
+private:
+  array<value, Size> slots;          //value of every attribute, in schema order
+  unique_ptr<Record<value>> dynamic;  //set instead when the record does not follow the schema
+
+  //Private helper functions
+  static Attribute attribute(size_t i);
+  static bool readSlot(const string& line, size_t i, value& val);
+
+};
+
+#include "fixedrecord.tem"
+
+#endif
@@ -0,0 +1,115 @@
+// FileFollower implementation
+
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include "follower.h"
+
+namespace {
+  const size_t ReadBlockSize = 1 << 20;
+}
+
+/*
+* Start following filename from its first byte, replacing any file followed before.
+* The first poll hands out every record the file already holds.
+*
+* Complexity: O(1)
+* Return: false if the file can not be opened or watched
+*/
+bool FileFollower::open(const string& filename) {
+  close();
+
+  file = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (file < 0)
+    return false;
+
+  struct stat st;
+  notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fstat(file, &st) != 0 || !S_ISREG(st.st_mode) || notify < 0 ||
+      inotify_add_watch(notify, filename.c_str(), IN_MODIFY | IN_ATTRIB) < 0) {
+    close();
+    return false;
+  }
+
+  changed = true;
+  return true;
+}
+
+/*
+* Collect the records completed since the last poll.
+* Nothing is read unless inotify reported a change, then every byte added since is read
+* and text receives the whole lines from the end of the last record handed out to the end
+* of the last complete one, so text always starts and ends on a record boundary.
+* A file that shrank below what was already read, or that has been removed, can not be
+* followed any further and is closed.
+*
+* Complexity: O(1) if the file has not changed, O(m) in the number of bytes added otherwise
+* Return: false once the file is no longer followed, text still holds any records completed before it was removed
+*/
+bool FileFollower::poll(string& text) {
+  text.clear();
+  if (file < 0)
+    return false;
+
+  //Drain the events, any of them means the file may have grown
+  alignas(inotify_event) char events[4096];
+  while (read(notify, events, sizeof(events)) > 0) {
+    changed = true;
+  }
+
+  if (!changed)
+    return true;
+  changed = false;
+
+  struct stat st;
+  if (fstat(file, &st) != 0 || size_t(st.st_size) < offset_ + pending.size()) {
+    close();
+    return false;
+  }
+
+  vector<char> block(ReadBlockSize);
+  off_t at = offset_ + pending.size();
+  ssize_t got;
+  while ((got = pread(file, block.data(), block.size(), at)) > 0) {
+    pending.append(block.data(), got);
+    at += got;
+  }
+
+  //Hand out everything up to the last "}" line, most of the time that is all of it
+  size_t cut = pending.rfind("\n}\n");
+  if (cut != string::npos) {
+    if (cut + 3 == pending.size())
+      text.swap(pending);
+    else {
+      text.assign(pending, 0, cut + 3);
+      pending.erase(0, cut + 3);
+    }
+    offset_ += text.size();
+  }
+
+  //Once the last name is gone nothing can append to the file any more
+  if (st.st_nlink == 0) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+/*
+* Stop following, forgetting the position reached.
+* Complexity: O(1)
+*/
+void FileFollower::close() {
+  if (file >= 0)
+    ::close(file);
+  if (notify >= 0)
+    ::close(notify);
+
+  file = -1;
+  notify = -1;
+  changed = false;
+  offset_ = 0;
+  pending.clear();
+}
@@ -0,0 +1,52 @@
+/**
+*  Follows a record file that another process keeps appending to.
+*
+*  The file is watched with inotify, so checking a file that has not changed
+*  costs a single non blocking read. Only the bytes added since the last
+*  check are read. They are handed out up to the end of the last complete
+*  record, the start of a record still being written is kept until the rest
+*  of it arrives. The file is followed by descriptor, as tail -f does, so it
+*  may be renamed while followed.
+*
+*  Author: Mohammad Ghasembeigi
+*
+*/
+
+#ifndef FOLLOWER_H
+#define FOLLOWER_H
+
+#include <string>
+
+using namespace std;
+
+class FileFollower {
+public:
+  //Default constructor
+  FileFollower() : file(-1), notify(-1), changed(false), offset_(0), pending() {}
+
+  //Member functions
+  bool open(const string& filename);
+  bool poll(string& text);
+  void close();
+
+  //Complexity of inlines: O(1)
+  inline bool isOpen() const { return file >= 0; }
+  inline size_t offset() const { return offset_; }
+
+  //Stops watching the file
+  ~FileFollower() { close(); }
+
+private:
+  int file;         //descriptor of the followed file
+  int notify;       //inotify instance watching it
+  bool changed;     //the file may have grown since it was last read
+  size_t offset_;   //bytes handed out so far, always the end of a complete record
+  string pending;   //bytes read past offset_, the start of an incomplete record
+
+  //Descriptors are owned by exactly one object
+  FileFollower(const FileFollower&);
+  FileFollower& operator=(const FileFollower&);
+
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define FRACTION_H
 
 #include <iostream>
+#include <functional>
 using namespace std;
 
 class Fraction {
@@ -69,4 +70,14 @@ Fraction operator*(int, const Fraction&);
 Fraction operator/(const Fraction&, int);
 Fraction operator/(int, const Fraction&);
 
+// Fractions are kept reduced, so equal fractions have equal parts and hash alike
+namespace std {
+   template <>
+   struct hash<Fraction> {
+      size_t operator()(const Fraction& f) const {
+         return hash<unsigned long long>()((static_cast<unsigned long long>(static_cast<unsigned>(f.Numerator())) << 32) ^ static_cast<unsigned>(f.Denominator()));
+      }
+   };
+}
+
 #endif
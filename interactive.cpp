@@ -27,13 +27,20 @@
 #include <cassert>
 #include <cstdlib>	// for exit()
 #include <cstring>	// for strncmp()
+#include <cctype>	// for isspace()
 #include <string>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <algorithm>
 using namespace std;
 
 #include "fraction.h"
 #include "utility.h"
 #include "record.h"
 #include "database.h"
+#include "allocstats.h"
+#include "follower.h"
 
 /* 
  * const maxline
@@ -43,24 +50,110 @@ using namespace std;
  * since all these buffers come from stack where space is cheap.
  */
 
-enum CommandT {Help, Read, Print, Select, Delete, Write, Quit, NumOptions};
+enum CommandT {Help, Read, Follow, Print, Select, Delete, Update, Write, Index, Type, Count, Min, Max, Sum, Avg, Group, Estimate, Distinct, Cache, Memory, Use, Join, Jobs, Wait, Cancel, Quit, NumOptions};
 static CommandT GetCommandFromUser();
 template <typename value> void GetCriteriaValue(value& val);
 void GetCriteriaValue(string& val);
-template <typename value> bool DispatchCommand(CommandT cmd, Database<value>& db);
-template <typename value> bool ReadCommand(Database<value>& db);
+void GetCriteriaValue(TypedValue& val);
+template <typename value> bool DispatchCommand(CommandT cmd, map<string, Database<value>>& dbs, string& current);
+template <typename value> bool ReadCommand(map<string, Database<value>>& dbs, const string& name);
+template <typename value> bool FollowCommand(Database<value>& db, const string& name);
 template <typename value> bool WriteCommand(Database<value>& db);
 template <typename value> bool PrintCommand(Database<value>& db);
-template <typename value> bool SelectCommand(Database<value>& db);
+template <typename value> bool SelectCommand(Database<value>& db, const string& name);
 template <typename value> bool DeleteCommand(Database<value>& db);
-template <typename value> bool SelectWithCriteria(DBSelectOperation type, Database<value>& db);
+template <typename value> bool UpdateCommand(Database<value>& db);
+template <typename value> bool IndexCommand(Database<value>& db);
+template <typename value> bool TypeCommand(Database<value>& db);
+template <typename value> bool AggregateCommand(CommandT cmd, Database<value>& db);
+template <typename value> bool GroupCommand(Database<value>& db);
+template <typename value> bool EstimateCommand(Database<value>& db);
+template <typename value> bool DistinctCommand(Database<value>& db);
+template <typename value> bool CacheCommand(Database<value>& db);
+template <typename value> bool MemoryCommand(Database<value>& db, const string& name);
+template <typename value> bool UseCommand(map<string, Database<value>>& dbs, string& current);
+template <typename value> bool JoinCommand(map<string, Database<value>>& dbs);
+//Records of a lazy read stay parsed once a query has parsed them, even when they no longer fit the budget
+template <typename value> void WarnSelectBudget(const Database<value>& db)
+{
+  if (db.exceededBudget())
+    cout << "ERROR: The records parsed by this query no longer fit in the memory budget of " << (db.memoryBudget() >> 20) << " MB.\n";
+}
+
+template <typename value> bool SelectWithCriteria(DBSelectOperation type, Database<value>& db, const string& name);
+template <typename value> bool GetCriteria(string& fieldname, DBQueryOperator& op, value& val);
+static bool GetWriteOptions(string arg, DBWriteOptions& options);
 static bool HelpCommand();
+static bool JobsCommand();
+static bool WaitCommand();
+static bool CancelCommand();
 static bool QuitCommand();
 static void PrintHelpFile(const string& filename);
 static void PrintMenuOptions();
 static void InitCommandLine();
 static string GetNextToken(bool singleWord = true);
 
+/* 
+ * Job
+ * ---
+ * A read or select running in the background on its own thread,
+ * started by ending the command with "&". Its messages are collected
+ * and printed when it finishes, complete then runs on the shell thread
+ * to apply the result, such as installing the records a read loaded.
+ * A job doing a select is exclusive: no other command may use its
+ * database until it finishes. A read loads into a new database, so
+ * the old records can be used until they are replaced.
+ */
+
+struct Job {
+  Job(unsigned id, const string& database, const string& command, bool exclusive)
+    : id(id), database(database), command(command), exclusive(exclusive), progress(), output(),
+      succeeded(false), finished(false), started(chrono::steady_clock::now()), complete(), worker() {}
+
+  unsigned id;
+  string database;
+  string command;
+  bool exclusive;
+
+  DBProgress progress;
+  ostringstream output;
+  bool succeeded;               //set by the worker before finished
+  atomic<bool> finished;
+  chrono::steady_clock::time_point started;
+
+  function<void()> complete;
+  thread worker;
+};
+
+static map<unsigned, unique_ptr<Job>> jobs;
+static bool background = false;  // true when the current command line ends with "&"
+
+static Job& StartJob(const string& database, bool exclusive);
+static Job* FindJob(const string& database);
+static void ReapJobs();
+static void PrintJobProgress(const Job& job);
+template <typename value> void PrintCounts(const string& name, const Database<value>& db);
+
+/* 
+ * Following
+ * ---------
+ * A file the database of the same name follows, with the number of
+ * records added to the database from the file since it was first read.
+ */
+
+struct Following {
+  Following(const string& filename) : filename(filename), file(), appended(0) {}
+
+  string filename;
+  FileFollower file;
+  size_t appended;
+};
+
+static map<string, unique_ptr<Following>> following;
+
+template <typename value> void CatchUpFollowed(map<string, Database<value>>& dbs);
+static bool StopFollowing(const string& database);
+
 /* 
  * MainLoop
  * --------
@@ -68,16 +161,38 @@ static string GetNextToken(bool singleWord = true);
  * and then dispatches that command appropriately.  The loop appears
  * to be infinite, but the "quit" command just directly uses exit()
  * to terminate when the user is done.
+ * Several databases can be loaded at once, each under its own name.
+ * Commands apply to the current one, which starts out as "main".
+ * Builds counting allocations also report those made by each command.
+ * Background jobs that have finished are reported before each prompt,
+ * records appended to followed files are added before each command.
  */
  
-template <typename value> void MainLoop(Database<value>& db)
+template <typename value> void MainLoop()
 { 
+  map<string, Database<value>> dbs;
+  string current = "main";
+  dbs[current];
+
   InitCommandLine();
   while(true) {
-    if (DispatchCommand(GetCommandFromUser(), db))
-      cout << "\n" << db.numRecords() << " records (" << db.numSelected() << " selected)\n";
+    ReapJobs();
+    CommandT command = GetCommandFromUser();
+    CatchUpFollowed(dbs);
+    unsigned long allocations = AllocationStats::allocations();
+    unsigned long bytes = AllocationStats::bytes();
+
+    if (DispatchCommand(command, dbs, current)) {
+      cout << "\n";
+      PrintCounts(current, dbs[current]);
+      cout << "\n";
+    }
     else 
       cout << "\n";
+
+    if (AllocationStats::enabled)
+      cout << AllocationStats::allocations() - allocations << " allocations ("
+           << AllocationStats::bytes() - bytes << " bytes)\n";
   }
 }
 
@@ -86,32 +201,34 @@ template <typename value> void MainLoop(Database<value>& db)
  * ----
  * The interactive code is templatized to 
  * work with any Database value type, this main 
- * just lets you pick from one of 3 types to test on.
+ * just lets you pick from one of 3 types to test on,
+ * or a typed database holding all of them.
  */
 
 int main()
 {
   PrintHelpFile("help_interactive");
   cout << "What type values would you like to test in the database?\n";
-  cout << "(1 = integer, 2 = string, 3 = Fraction): ";
+  cout << "(1 = integer, 2 = string, 3 = Fraction, 4 = typed): ";
   int choice;
   cin >> choice;
   switch (choice) {
   case 1: { 
-    Database<int> db;
-    MainLoop(db);
+    MainLoop<int>();
     break; 
   }
   case 2: { 
-    Database<string> db;
-    MainLoop(db);
+    MainLoop<string>();
     break; 
   }
   case 3: { 
-    Database<Fraction> db;
-    MainLoop(db);
+    MainLoop<Fraction>();
     break; 
   }
+  case 4: {
+    MainLoop<TypedValue>();
+    break;
+  }
   default:
     cout << "Invalid choice, exiting.\n";
   }
@@ -123,14 +240,46 @@ int main()
  * The most straightforward of command dispatch routines.
  */
  
-template <typename value> bool DispatchCommand(CommandT command, Database<value>& db)
+template <typename value> bool DispatchCommand(CommandT command, map<string, Database<value>>& dbs, string& current)
 {
+  if (background && command != Read && command != Select) {
+    cout << "ERROR: Only read and select can run in the background.\n";
+    return false;
+  }
+
+  //Commands that do not touch the current database can always run
+  Job* job = FindJob(current);
+  bool independent = command == Help || command == Use || command == Join || command == Jobs ||
+                     command == Wait || command == Cancel || command == Quit;
+  //A read job replaces the records when it finishes, so neither another read nor a follow may start
+  if (job != NULL && !independent && (job->exclusive || command == Read || command == Follow || background)) {
+    cout << "ERROR: Database \"" << current << "\" is in use by job [" << job->id << "].\n";
+    return false;
+  }
+
+  Database<value>& db = dbs[current];
   switch(command) {
-  case Read:   return ReadCommand(db); 
+  case Read:   return ReadCommand(dbs, current); 
+  case Follow: return FollowCommand(db, current);
   case Write:  return WriteCommand(db);
   case Print:  return PrintCommand(db);
-  case Select: return SelectCommand(db); 
+  case Select: return SelectCommand(db, current); 
   case Delete: return DeleteCommand(db);
+  case Update: return UpdateCommand(db);
+  case Index:  return IndexCommand(db);
+  case Type:   return TypeCommand(db);
+  case Count: case Min: case Max: case Sum: case Avg:
+    return AggregateCommand(command, db);
+  case Group:  return GroupCommand(db);
+  case Estimate: return EstimateCommand(db);
+  case Distinct: return DistinctCommand(db);
+  case Cache:  return CacheCommand(db);
+  case Memory: return MemoryCommand(db, current);
+  case Use:    return UseCommand(dbs, current);
+  case Join:   return JoinCommand(dbs);
+  case Jobs:   return JobsCommand();
+  case Wait:   return WaitCommand();
+  case Cancel: return CancelCommand();
   case Help:   return HelpCommand(); 
   case Quit:   return QuitCommand();
   default: assert(0); return false;
@@ -157,15 +306,53 @@ static struct {
   { Help, "help", 
       "Print this table of the command descriptions."},
     { Read, "read", 
-   	"Read database in from file (replaces current db). Requires filename arg."},
+   	"Read database in from file (replaces current db). Requires filename arg, add lazy, paged [MB] or compressed."},
+    { Follow, "follow",
+	"Read a file and keep adding records appended to it. Add \"stop\" to stop, lists followed files without an arg."},
       { Print, "print", 
-	  "Print selected records. Can add arg \"all\" to print all records."},
+	  "Print selected records. Can add arg \"all\", a field list, order by and limit."},
 	{ Select, "select", 
 	    "Defines and changes selection. Try select with no args for more help."},
 	  { Delete, "delete", 
 	      "Delete selected records. Can add arg \"all\" to delete all records."},
+	    { Update, "update",
+		"update set <field> = <value> changes the field in every selected record."},
 	    { Write, "write", 
-		"Write current database to a file. Requires filename arg."},
+		"Write current database to a file. Requires filename arg, add \"compressed\" for binary."},
+	      { Index, "index",
+		  "Index a field so ordered output avoids sorting. Add \"drop\" to remove."},
+	      { Type, "type",
+		  "type <field> int|fraction|string declares the type of a field in a typed db. Lists types without args."},
+	      { Count, "count",
+		  "Count selected records, or values of the field given as arg."},
+	      { Min, "min",
+		  "Smallest value of a field in the selection. Requires field arg."},
+	      { Max, "max",
+		  "Largest value of a field in the selection. Requires field arg."},
+	      { Sum, "sum",
+		  "Sum of a numeric field in the selection. Requires field arg."},
+	      { Avg, "avg",
+		  "Average of a numeric field in the selection. Requires field arg."},
+	      { Group, "group",
+		  "group by <field> [over <field>] [order by key|count|sum|min|max [desc]]"},
+	      { Estimate, "estimate",
+		  "estimate select add|remove|refine <criteria> guesses the records it would change."},
+	      { Distinct, "distinct",
+		  "Approximate number of distinct values of the field given as arg, over all records."},
+	      { Cache, "cache",
+		  "Show select result cache statistics. Can add a budget in MB (0 disables) or \"clear\"."},
+	      { Memory, "memory",
+		  "Show memory used by the database. Can add a budget in MB (0 for none) to stay within."},
+	      { Use, "use",
+		  "Switch to (or create) the named database. Lists the databases without an arg."},
+	      { Join, "join",
+		  "join <db>.<field> = <db>.<field> prints records of both sharing a value."},
+	      { Jobs, "jobs",
+		  "List background jobs, started by ending a read or select with \"&\"."},
+	      { Wait, "wait",
+		  "Wait for a background job to finish, or for all of them without an arg."},
+	      { Cancel, "cancel",
+		  "Cancel the background job whose number is given as arg."},
 	      { Quit, "quit", 
 		  "Quit the program."},
 		{}
@@ -189,30 +376,93 @@ static bool HelpCommand()
 
 /* QuitCommand
  * -----------
- * When quit is chosen.  Just exits the program.
+ * When quit is chosen.  Cancels any background jobs, waiting for
+ * them to stop, and exits the program.
  */
 
 static bool QuitCommand()
 {
+  for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+    it->second->progress.cancel = true;
+    it->second->worker.join();
+  }
   cout << "Thanks for visiting!\n";
   exit(0);
   return true;  // doesn't get here, but compiler doesn't know that
 }
 
+/* 
+ * PrintPage
+ * ---------
+ * Where the last limited print of a database stopped, kept
+ * so that "print next" can carry on from there.
+ */
+
+struct PrintPage {
+  DBScope scope;
+  DBWriteOptions options;
+  size_t next;
+  unsigned long version;  //records version the page was printed from
+};
+
 /* 
  * PrintCommand
  * ------------
  * When print is chosen.  If the option argument 
  * "all" is specified, prints all the records in the 
  * database, otherwise just prints the records in the 
- * current selection.
+ * current selection. Output can be restricted to a list
+ * of fields, ordered, limited and offset with trailing arguments.
+ * After a print with a limit, "print next" prints the following
+ * page, resuming from where the last one stopped.
  */
 
 template <typename value> bool PrintCommand(Database<value>& db)
 {
+  static map<const Database<value>*, PrintPage> pages;
+
   string arg = GetNextToken();
+  if (arg == "next") {
+    auto it = pages.find(&db);
+    if (it == pages.end() || it->second.version != db.recordsVersion()) {
+      cout << "ERROR: There is no page to continue, print with a limit first.\n";
+      return false;
+    }
+
+    PrintPage& page = it->second;
+    if (page.next >= size_t(db.numRecords())) {
+      cout << "No more records.\n";
+      return true;
+    }
+
+    page.options.from = page.next;
+    page.options.offset = 0;
+    db.write(cout, page.scope, page.options, &page.next);
+    if (page.next < size_t(db.numRecords()))
+      cout << "More records follow, \"print next\" continues.\n";
+    return true;
+  }
+
   bool doAll = arg != "" && strncmp(arg.c_str(), "all", arg.length()) == 0;
-  db.write(cout, doAll? AllRecords: SelectedRecords);
+  if (doAll) arg = GetNextToken();
+
+  DBWriteOptions options;
+  if (!GetWriteOptions(arg, options)) return false;
+  if (!options.orderBy.empty() && db.isPaged()) {
+    cout << "ERROR: Paged records can not be ordered.\n";
+    return false;
+  }
+
+  PrintPage page = { doAll? AllRecords: SelectedRecords, options, 0, db.recordsVersion() };
+  db.write(cout, page.scope, options, &page.next);
+
+  if (options.limit)
+    pages[&db] = page;
+  else
+    pages.erase(&db);
+
+  if (page.next < size_t(db.numRecords()))
+    cout << "More records follow, \"print next\" continues.\n";
   return true;
 }
 
@@ -227,7 +477,10 @@ template <typename value> bool DeleteCommand(Database<value>& db)
 {
   string arg = GetNextToken();
   bool doAll = arg != "" && strncmp(arg.c_str(), "all", arg.length()) == 0;
-  db.deleteRecords(doAll? AllRecords: SelectedRecords);
+  if (!db.deleteRecords(doAll? AllRecords: SelectedRecords)) {
+    cout << "ERROR: Cannot write paged storage, no records were kept.\n";
+    return false;
+  }
   return true;
 }
 
@@ -237,25 +490,275 @@ template <typename value> bool DeleteCommand(Database<value>& db)
  * to read from. The database contents are wiped out and replaced by
  * the new records read from the named file.  The database is unchanged
  * if no filename argument was given or the named file could not be
- * opened.
+ * opened. An optional "lazy" argument maps the file and only locates
+ * the records, parsing each one when it is first used. A "paged"
+ * argument keeps the records on disk instead, with an optional size
+ * in MB of the pages held in memory (64 by default). Paged records
+ * can not be ordered or indexed. A "compressed" argument reads a
+ * file written by write with the same argument. Typed databases
+ * convert values as they are read, so can not be read lazy or paged.
+ * In the background the records are read into a new database, which
+ * replaces the named one when the job finishes. Until then, or if the
+ * job is cancelled, the old records stay in place.
+ * A database that was following a file stops following it.
+ */
+
+struct ReadRequest {
+  string filename;
+  string mode;
+  int budgetMB;
+};
+
+static bool GetReadRequest(ReadRequest& request)
+{
+  request.filename = GetNextToken();
+  if (request.filename == "") {
+    cout << "ERROR: Read requires an argument of file to read from.\n";
+    return false;
+  }
+
+  request.mode = GetNextToken();
+  if (request.mode != "" && request.mode != "lazy" && request.mode != "paged" && request.mode != "compressed") {
+    cout << "ERROR: Unknown read mode \"" << request.mode << "\".\n";
+    return false;
+  }
+
+  request.budgetMB = 64;
+  string arg = request.mode == "paged" ? GetNextToken() : "";
+  if (arg != "") {
+    istringstream budgetStream(arg);
+    if (!(budgetStream >> request.budgetMB) || request.budgetMB <= 0) {
+      cout << "ERROR: Paged read expects a size in MB, not \"" << arg << "\".\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+//Messages go to out, which a background job shows once it finishes
+template <typename value> bool RunRead(Database<value>& db, const ReadRequest& request, ostream& out)
+{
+  const string& filename = request.filename;
+  const string& mode = request.mode;
+
+  if (AttributeTypes<value>::Typed && (mode == "lazy" || mode == "paged")) {
+    out << "ERROR: A typed database can not be read " << mode << ".\n";
+    return false;
+  }
+
+  if (mode == "lazy") {
+    if (!db.readLazy(filename)) {
+      out << "ERROR: Cannot map file named \"" << filename << "\".\n";
+      return false;
+    }
+  }
+  else {
+    ifstream in(filename.c_str(), ios::in | ios::binary);
+    if (!in) {
+      out << "ERROR: Cannot open file named \"" << filename << "\".\n";
+      return false;
+    }
+
+    if (mode == "compressed") {
+      if (!db.readCompressed(in)) {
+        out << "ERROR: File named \"" << filename << "\" is not compressed, or is truncated or corrupt.\n";
+        return false;
+      }
+    }
+    else if (mode == "paged") {
+      if (!db.readPaged(in, size_t(request.budgetMB) << 20)) {
+        out << "ERROR: Cannot create or write paged storage for \"" << filename << "\".\n";
+        return false;
+      }
+    }
+    else
+      db.read(in);
+  }
+
+  if (db.exceededBudget()) {
+    out << "ERROR: \"" << filename << "\" does not fit in the memory budget of " << (db.memoryBudget() >> 20)
+        << " MB, no records were kept.\n";
+    return false;
+  }
+  out << "Read "<< db.numRecords() << " records from \""<< filename <<"\".\n";
+  return true;
+}
+
+template <typename value> bool ReadCommand(map<string, Database<value>>& dbs, const string& name)
+{
+  ReadRequest request;
+  if (!GetReadRequest(request)) return false;
+  StopFollowing(name);
+  if (!background) return RunRead(dbs[name], request, cout);
+
+  //The new database keeps the settings of the one it replaces, including any changed while the job ran
+  shared_ptr<Database<value>> loaded(new Database<value>());
+  loaded->copySettings(dbs[name]);
+  Job& job = StartJob(name, false);
+  job.complete = [&dbs, name, loaded]() {
+    loaded->copySettings(dbs[name]);
+    swap(dbs[name], *loaded);
+    cout << name << ": " << dbs[name].numRecords() << " records (" << dbs[name].numSelected() << " selected)\n";
+  };
+  job.worker = thread([&job, loaded, request]() {
+    loaded->setProgress(&job.progress);
+    job.succeeded = RunRead(*loaded, request, job.output);
+    loaded->setProgress(NULL);
+    job.finished = true;
+  });
+  return false;
+}
+
+/* FollowCommand
+ * -------------
+ * When follow is chosen.  follow <file> reads the file as read does,
+ * replacing the current database, and keeps following it: records
+ * another program appends to the file are added to the database
+ * before each command. Only the bytes added are read and only the
+ * new records parsed, a record still being written is added once its
+ * closing "}" line is. "follow stop" stops following, and without an
+ * argument the files followed by every database are listed.
  */
 
-template <typename value> bool ReadCommand(Database<value>& db)
+template <typename value> bool FollowCommand(Database<value>& db, const string& name)
 {
   string filename = GetNextToken();
   if (filename == "") {
-    cout << "ERROR: Read requires an argument of file to read from.\n";
+    if (following.empty())
+      cout << "Not following any files.\n";
+    for (auto it = following.begin(); it != following.end(); ++it) {
+      cout << it->first << ": following \"" << it->second->filename << "\", " << it->second->file.offset()
+           << " bytes read, " << it->second->appended << " records appended\n";
+    }
     return false;
   }
-  
-  ifstream in(filename.c_str());
-  if (!in) {
+
+  if (filename == "stop") {
+    if (!StopFollowing(name))
+      cout << "ERROR: Database \"" << name << "\" is not following a file.\n";
+    return false;
+  }
+
+  unique_ptr<Following> follow(new Following(filename));
+  if (!follow->file.open(filename)) {
     cout << "ERROR: Cannot open file named \"" << filename << "\".\n";
     return false;
   }
-  
+  StopFollowing(name);
+
+  string text;
+  follow->file.poll(text);
+  istringstream in(text);
   db.read(in);
-  cout << "Read " << db.numRecords() << " records from \""<< filename <<"\".\n";
+
+  if (db.exceededBudget()) {
+    cout << "ERROR: \"" << filename << "\" does not fit in the memory budget of " << (db.memoryBudget() >> 20)
+         << " MB, no records were kept.\n";
+    return true;
+  }
+
+  cout << "Read " << db.numRecords() << " records from \""<< filename <<"\", following it for new records.\n";
+  following[name] = std::move(follow);
+  return true;
+}
+
+/* CatchUpFollowed
+ * ---------------
+ * Adds the records appended to every followed file since the last
+ * command to its database. A database in use by a background job
+ * catches up once the job has finished. Files that were truncated
+ * or removed are no longer followed, nor are files whose records no
+ * longer fit in the memory budget of their database.
+ */
+
+template <typename value> void CatchUpFollowed(map<string, Database<value>>& dbs)
+{
+  for (auto it = following.begin(); it != following.end(); ) {
+    Following& follow = *it->second;
+    if (FindJob(it->first) != NULL) {
+      ++it;
+      continue;
+    }
+
+    string text;
+    bool open = follow.file.poll(text);
+    if (!text.empty()) {
+      istringstream in(text);
+      Database<value>& db = dbs[it->first];
+      int added = db.append(in);
+      follow.appended += added;
+      cout << it->first << ": " << added << " new records from \"" << follow.filename << "\".\n";
+
+      if (db.exceededBudget()) {
+        cout << "ERROR: Stopped following \"" << follow.filename << "\", its records no longer fit in the memory budget of "
+             << (db.memoryBudget() >> 20) << " MB.\n";
+        it = following.erase(it);
+        continue;
+      }
+    }
+
+    if (!open) {
+      cout << "Stopped following \"" << follow.filename << "\", it was truncated or removed.\n";
+      it = following.erase(it);
+      continue;
+    }
+    ++it;
+  }
+}
+
+/* StopFollowing
+ * -------------
+ * Stops the named database following its file, if it follows one.
+ */
+
+static bool StopFollowing(const string& database)
+{
+  auto it = following.find(database);
+  if (it == following.end())
+    return false;
+
+  cout << "Stopped following \"" << it->second->filename << "\".\n";
+  following.erase(it);
+  return true;
+}
+
+/* UpdateCommand
+ * -------------
+ * When update is chosen.  Expects "set <field> = <value>" and sets
+ * the field to the value in every selected record, adding the field
+ * to records that do not have it. Records with several values of the
+ * field have all of them replaced. The field must be named, "*"
+ * stands for any field in queries and is not a field to set.
+ */
+
+template <typename value> bool UpdateCommand(Database<value>& db)
+{
+  string fieldname, arg = GetNextToken();
+  bool valid = arg == "set";
+
+  //Field names may contain spaces, so collect words up to the "="
+  while (valid && (arg = GetNextToken()) != "=") {
+    if (arg == "") valid = false;
+    else fieldname += " " + arg;
+  }
+  TrimString(fieldname);
+
+  if (!valid || fieldname == "" || fieldname == "*" || fieldname.find(" = ") != string::npos) {
+    cout << "ERROR: Expected set <field> = <value>.\n";
+    return false;
+  }
+  if (db.isPaged()) {
+    cout << "ERROR: Paged records can not be updated.\n";
+    return false;
+  }
+  if (!db.numSelected()) {
+    cout << "ERROR: No records selected.\n";
+    return false;
+  }
+
+  value val;
+  GetCriteriaValue(val);
+  cout << "Updated " << db.update(fieldname, val) << " records.\n";
   return true;
 }
 
@@ -268,6 +771,8 @@ template <typename value> bool ReadCommand(Database<value>& db)
  * contents are written to the named file.  
  * The database itself is unchanged. If no filename argument was given 
  * or the named file could not be opened, the write is aborted.
+ * A "compressed" argument after the filename writes the records in
+ * the compact binary format instead, which read can load back.
  */
 
 template <typename value> bool WriteCommand(Database<value>& db)
@@ -278,18 +783,506 @@ template <typename value> bool WriteCommand(Database<value>& db)
     return false;
   }
   
-  ofstream out(filename.c_str());
+  string arg = GetNextToken();
+  bool compressed = arg == "compressed";
+  ofstream out(filename.c_str(), compressed ? ios::out | ios::binary : ios::out);
   if (!out) {
     cout << "ERROR: Cannot open file named \"" << filename << "\".\n";
     return false;
   }
-  
+
   bool doAll = !db.numSelected();
-  db.write(out, doAll? AllRecords : SelectedRecords);
-  cout << "Wrote " << (doAll ? db.numRecords() : db.numSelected()) << " records to \""<< filename <<"\".\n";
+  if (compressed) {
+    int written = db.writeCompressed(out, doAll ? AllRecords : SelectedRecords);
+    cout << "Wrote " << written << " compressed records to \""<< filename <<"\".\n";
+    return true;
+  }
+
+  DBWriteOptions options;
+  if (!GetWriteOptions(arg, options)) return false;
+  if (!options.orderBy.empty() && db.isPaged()) {
+    cout << "ERROR: Paged records can not be ordered.\n";
+    return false;
+  }
+
+  int written = db.write(out, doAll? AllRecords : SelectedRecords, options);
+  cout << "Wrote " << written << " records to \""<< filename <<"\".\n";
   return true;
 }
 
+/* AggregateCommand
+ * ----------------
+ * When count, min, max, sum or avg is chosen.  The rest of the line
+ * names the field to aggregate (* for any field). Like write, the
+ * selected records are used if there are any, otherwise all records.
+ * count without a field just counts those records.
+ */
+
+template <typename value> bool AggregateCommand(CommandT cmd, Database<value>& db)
+{
+  string fieldname = GetNextToken(false);
+  bool doAll = !db.numSelected();
+  const char *name = menu[cmd].name;
+
+  if (fieldname == "") {
+    if (cmd == Count) {
+      cout << name << " = " << (doAll ? db.numRecords() : db.numSelected()) << " records\n";
+      return true;
+    }
+    cout << "ERROR: " << name << " requires a field name argument.\n";
+    return false;
+  }
+
+  Aggregate<value> agg = db.aggregate(fieldname, doAll ? AllRecords : SelectedRecords);
+  if ((cmd == Sum || cmd == Avg) && !agg.hasSum()) {
+    cout << "ERROR: " << name << " is not defined for this type of value.\n";
+    return false;
+  }
+  if ((cmd == Sum || cmd == Avg) && agg.sum().overflowed()) {
+    cout << "ERROR: " << name << " of field \"" << fieldname << "\" overflowed.\n";
+    return false;
+  }
+
+  cout << name << "(" << fieldname << ") = ";
+  if (cmd == Count)
+    cout << agg.count();
+  else if (agg.count() == 0)
+    cout << "none";
+  else if (cmd == Min)
+    cout << agg.min();
+  else if (cmd == Max)
+    cout << agg.max();
+  else if (cmd == Sum)
+    agg.sum().write(cout);
+  else
+    agg.sum().writeAverage(cout, agg.count());
+  cout << " over " << agg.count() << " values\n";
+  return true;
+}
+
+/* GroupCommand
+ * ------------
+ * When group is chosen.  Expects "by <field>" naming the field whose
+ * values form the groups, optionally "over <field>" naming a field
+ * to sum, min and max within each group, and optionally an "order by"
+ * clause choosing what the groups are sorted on (key by default).
+ * Like write, the selected records are used if there are any.
+ */
+
+static struct {
+  DBGroupOrder order;
+  const char *name;
+} groupOrders[] = {
+  { ByKey, "key" },
+    { ByCount, "count" },
+      { BySum, "sum" },
+	{ ByMin, "min" },
+	  { ByMax, "max" },
+	    {}
+};
+
+template <typename value> bool GroupCommand(Database<value>& db)
+{
+  string keyField, valueField, arg = GetNextToken();
+  DBGroupOrder order = ByKey;
+  bool descending = false;
+  bool valid = arg == "by";
+
+  //Field names may contain spaces, so collect words up to the next keyword
+  string *field = &keyField;
+  while (valid && (arg = GetNextToken()) != "" && arg != "order") {
+    if (arg == "over" && field == &keyField) field = &valueField;
+    else *field += " " + arg;
+  }
+  TrimString(keyField);
+  TrimString(valueField);
+  valid = valid && keyField != "" && (field == &keyField || valueField != "");
+
+  if (valid && arg == "order") {
+    valid = GetNextToken() == "by";
+    string name = GetNextToken();
+    int i = 0;
+    while (groupOrders[i].name != NULL && name != groupOrders[i].name) i++;
+    valid = valid && groupOrders[i].name != NULL;
+    if (valid) order = groupOrders[i].order;
+
+    arg = GetNextToken();
+    if (arg == "asc" || arg == "desc") {
+      descending = arg == "desc";
+      arg = GetNextToken();
+    }
+    valid = valid && arg == "";
+  }
+
+  if (!valid) {
+    cout << "ERROR: Expected group by <field> [over <field>] [order by key|count|sum|min|max [asc|desc]].\n";
+    return false;
+  }
+  if (order != ByKey && order != ByCount && valueField == "") {
+    cout << "ERROR: Ordering by an aggregate requires an \"over\" field.\n";
+    return false;
+  }
+
+  Aggregate<value> probe;
+  if (order == BySum && !probe.hasSum()) {
+    cout << "ERROR: sum is not defined for this type of value.\n";
+    return false;
+  }
+
+  bool doAll = !db.numSelected();
+  vector<DBGroup<value> > groups = db.groupBy(keyField, valueField, doAll ? AllRecords : SelectedRecords, order, descending);
+
+  for (auto it = groups.begin(); it != groups.end(); ++it) {
+    cout << "  " << keyField << " = " << it->key << ": " << it->records << " records";
+    if (valueField != "") {
+      cout << ", " << it->values.count() << " values";
+      if (it->values.count() > 0) {
+        if (probe.hasSum()) {
+          cout << ", sum ";
+          if (it->values.sum().overflowed()) cout << "overflow";
+          else it->values.sum().write(cout);
+        }
+        cout << ", min " << it->values.min() << ", max " << it->values.max();
+      }
+    }
+    cout << '\n';
+  }
+  cout << groups.size() << " groups\n";
+  return true;
+}
+
+/* GetWriteOptions
+ * ---------------
+ * Parses the optional arguments shared by print and write, starting
+ * at token arg:  [<field>, <field>, ...] [order by <field> [asc|desc]] [limit <N>]
+ * The field list restricts output to the named fields. Like criteria,
+ * field names may contain spaces. Reports an error and returns false
+ * if the arguments are ill-formed.
+ */
+
+static bool GetWriteOptions(string arg, DBWriteOptions& options)
+{
+  //Everything before the first keyword is the comma separated field list
+  string fieldlist;
+  while (arg != "" && arg != "order" && arg != "limit" && arg != "offset") {
+    fieldlist += " " + arg;
+    arg = GetNextToken();
+  }
+
+  istringstream fieldStream(fieldlist);
+  string fieldname;
+  while (getline(fieldStream, fieldname, ',')) {
+    TrimString(fieldname);
+    if (fieldname != "") options.fields.push_back(fieldname);
+  }
+
+  while (arg != "") {
+    if (arg == "order") {
+      if (GetNextToken() != "by") break;
+
+      string fieldname;
+      while (true) {
+        arg = GetNextToken();
+        if (arg == "" || arg == "limit" || arg == "offset") break;
+        if (arg == "asc" || arg == "desc") {
+          options.descending = arg == "desc";
+          arg = GetNextToken();
+          break;
+        }
+        fieldname += " " + arg;
+      }
+
+      TrimString(fieldname);
+      if (fieldname == "") break;
+      options.orderBy = fieldname;
+    }
+    else if (arg == "limit") {
+      istringstream limitStream(GetNextToken());
+      int limit = 0;
+      if (!(limitStream >> limit) || limit <= 0) break;
+      options.limit = limit;
+      arg = GetNextToken();
+    }
+    else if (arg == "offset") {
+      istringstream offsetStream(GetNextToken());
+      int offset = -1;
+      if (!(offsetStream >> offset) || offset < 0) break;
+      options.offset = offset;
+      arg = GetNextToken();
+    }
+    else break;
+  }
+
+  if (arg != "") {
+    cout << "ERROR: Expected [<field>, ...] [order by <field> [asc|desc]] [limit <N>] [offset <M>].\n";
+    return false;
+  }
+  return true;
+}
+
+/* IndexCommand
+ * ------------
+ * When index is chosen.  The rest of the line names the field to
+ * index, or "drop" followed by the field whose index is removed.
+ * Indexed fields are used by "order by" to avoid sorting.
+ */
+
+template <typename value> bool IndexCommand(Database<value>& db)
+{
+  string fieldname = GetNextToken(false);
+  bool drop = fieldname.compare(0, 5, "drop ") == 0;
+  if (drop) {
+    fieldname = fieldname.substr(5);
+    TrimString(fieldname);
+  }
+
+  if (fieldname == "") {
+    cout << "ERROR: Index requires a field name argument.\n";
+    return false;
+  }
+
+  if (!drop && db.isPaged()) {
+    cout << "ERROR: Paged records can not be indexed.\n";
+    return false;
+  }
+
+  if (!drop) {
+    db.createIndex(fieldname);
+    cout << "Indexed field \"" << fieldname << "\".\n";
+  }
+  else if (db.dropIndex(fieldname))
+    cout << "Dropped index on field \"" << fieldname << "\".\n";
+  else {
+    cout << "ERROR: Field \"" << fieldname << "\" is not indexed.\n";
+    return false;
+  }
+  return true;
+}
+
+/* TypeCommand
+ * -----------
+ * When type is chosen.  The rest of the line names a field followed by
+ * the type its values are declared to have, one of int, fraction or
+ * string.  Values that can not be written as that type keep their own
+ * and are counted as misfits.  Without arguments the type of every field
+ * is listed, declared or inferred from its values.  Only typed databases
+ * have types.
+ */
+
+template <typename value> bool TypeCommand(Database<value>& db)
+{
+  if (!AttributeTypes<value>::Typed) {
+    cout << "ERROR: Only a typed database has field types.\n";
+    return false;
+  }
+
+  string args = GetNextToken(false);
+  if (args == "") {
+    vector<pair<string, AttributeType> > types;
+    db.attributeTypes().forEachType([&](Attribute attr, const AttributeType& type) {
+      types.push_back(make_pair(*attr, type));
+    });
+    sort(types.begin(), types.end(), [](const pair<string, AttributeType>& a, const pair<string, AttributeType>& b) {
+      return a.first < b.first;
+    });
+
+    for (auto it = types.begin(); it != types.end(); ++it) {
+      cout << "  " << it->first << ": " << TypedValue::typeName(it->second.type)
+           << (it->second.declared ? " (declared)" : " (inferred)");
+      if (it->second.misfits > 0)
+        cout << ", " << it->second.misfits << " misfits";
+      cout << '\n';
+    }
+    cout << types.size() << " fields\n";
+    return true;
+  }
+
+  //The last word is the type, field names may contain spaces
+  size_t split = args.find_last_of(' ');
+  string fieldname = split == string::npos ? "" : args.substr(0, split);
+  string typeName = split == string::npos ? args : args.substr(split + 1);
+  TrimString(fieldname);
+
+  ValueType type;
+  if (fieldname == "" || !TypedValue::typeOf(typeName, type)) {
+    cout << "ERROR: Type expects a field name followed by int, fraction or string.\n";
+    return false;
+  }
+
+  db.declareType(fieldname, type);
+  cout << "Field \"" << fieldname << "\" is now of type " << typeName << ".\n";
+  return true;
+}
+
+/* DistinctCommand
+ * ---------------
+ * When distinct is chosen.  The rest of the line names the field (* for
+ * any field) whose number of distinct values over all records is
+ * estimated, from a sketch of its values kept by the database.
+ */
+
+template <typename value> bool DistinctCommand(Database<value>& db)
+{
+  string fieldname = GetNextToken(false);
+  if (fieldname == "") {
+    cout << "ERROR: distinct requires a field name argument.\n";
+    return false;
+  }
+
+  double distinct = db.distinctValues(fieldname);
+  cout << "distinct(" << fieldname << ") = about " << llround(distinct) << " values, typically within "
+       << llround(HyperLogLog::standardError() * 1000) / 10.0 << "%\n";
+  return false;
+}
+
+/* CacheCommand
+ * ------------
+ * When cache is chosen.  Without arguments prints how the select result
+ * cache is doing. A number sets the memory budget of the cache in MB,
+ * 0 turns caching off, and "clear" empties it.
+ */
+
+template <typename value> bool CacheCommand(Database<value>& db)
+{
+  string arg = GetNextToken();
+  if (arg == "clear")
+    db.clearQueryCache();
+  else if (arg != "") {
+    istringstream budgetStream(arg);
+    int budgetMB;
+    if (!(budgetStream >> budgetMB) || budgetMB < 0) {
+      cout << "ERROR: Expected a cache budget in MB or \"clear\", not \"" << arg << "\".\n";
+      return false;
+    }
+    db.setQueryCacheBudget(size_t(budgetMB) << 20);
+  }
+
+  const QueryCache& cache = db.cache();
+  cout << "Cache holds " << cache.size() << " results in " << cache.sizeBytes() << " of "
+       << cache.budgetBytes() << " bytes, " << cache.numHits() << " hits and "
+       << cache.numMisses() << " misses.\n";
+  return true;
+}
+
+/* MemoryCommand
+ * -------------
+ * When memory is chosen.  Prints the approximate memory used by each
+ * structure of the current database and in total. A number sets the
+ * memory budget of the database in MB, 0 removes it. While over the
+ * budget the cache, indexes, sketches and zone map are dropped to be
+ * rebuilt when needed, and reads of files that do not fit it fail.
+ */
+
+template <typename value> bool MemoryCommand(Database<value>& db, const string& name)
+{
+  string arg = GetNextToken();
+  if (arg != "") {
+    istringstream budgetStream(arg);
+    int budgetMB;
+    if (!(budgetStream >> budgetMB) || budgetMB < 0) {
+      cout << "ERROR: Expected a memory budget in MB, not \"" << arg << "\".\n";
+      return false;
+    }
+    db.setMemoryBudget(size_t(budgetMB) << 20);
+  }
+
+  DBMemory usage = db.memoryUsage();
+  const struct { const char* name; size_t bytes; } parts[] = {
+    { "records", usage.records }, { "string values", usage.values }, { "selection", usage.selection },
+    { "zone map", usage.zones }, { "sample", usage.sample }, { "sketches", usage.sketches },
+    { "trigram index", usage.trigrams }, { "sorted indexes", usage.indexes },
+    { "cache", usage.cache }, { "pages", usage.pages }
+  };
+
+  cout << "Memory used by \"" << name << "\":\n";
+  for (size_t i = 0; i < sizeof(parts) / sizeof(parts[0]); ++i) {
+    if (parts[i].bytes != 0)
+      cout << "  " << parts[i].name << ": " << parts[i].bytes << " bytes\n";
+  }
+
+  cout << "Total " << usage.total() << " bytes";
+  if (db.memoryBudget() != 0)
+    cout << " of a " << (db.memoryBudget() >> 20) << " MB budget" << (usage.total() > db.memoryBudget() ? ", over it" : "");
+  cout << ", not counting " << usage.mapped << " bytes of mapped file and "
+       << usage.names << " bytes of attribute names shared by every database.\n";
+  return false;
+}
+
+/* UseCommand
+ * ----------
+ * When use is chosen.  The next argument names the database the
+ * following commands apply to, it is created empty if it does not
+ * exist yet. Without an argument the loaded databases are listed.
+ */
+
+template <typename value> bool UseCommand(map<string, Database<value>>& dbs, string& current)
+{
+  string name = GetNextToken();
+  if (name == "") {
+    for (auto it = dbs.begin(); it != dbs.end(); ++it) {
+      cout << (it->first == current ? "* " : "  ") << it->first << "\t";
+      PrintCounts(it->first, it->second);
+      cout << "\n";
+    }
+    return false;
+  }
+
+  if (name.find('.') != string::npos) {
+    cout << "ERROR: Database names can not contain \".\".\n";
+    return false;
+  }
+
+  current = name;
+  cout << "Using database \"" << name << "\".\n";
+  return true;
+}
+
+/* JoinCommand
+ * -----------
+ * When join is chosen.  Expects "<db>.<field> = <db>.<field>" naming
+ * two loaded databases (possibly the same one) and a field of each.
+ * Every pair of records with a common value of those fields is printed
+ * as one record holding the fields of both. Like write, each side uses
+ * its selected records if there are any, otherwise all its records.
+ */
+
+template <typename value> bool JoinCommand(map<string, Database<value>>& dbs)
+{
+  string criteria = GetNextToken(false);
+  size_t equals = criteria.find(" = ");
+  string sides[2] = { criteria.substr(0, equals), equals == string::npos ? "" : criteria.substr(equals + 3) };
+  Database<value>* db[2];
+  string field[2];
+
+  for (int i = 0; i < 2; ++i) {
+    TrimString(sides[i]);
+    size_t dot = sides[i].find('.');
+    if (dot == string::npos || dot == 0 || dot + 1 == sides[i].length()) {
+      cout << "ERROR: Expected <db>.<field> = <db>.<field>.\n";
+      return false;
+    }
+
+    auto it = dbs.find(sides[i].substr(0, dot));
+    if (it == dbs.end()) {
+      cout << "ERROR: No database named \"" << sides[i].substr(0, dot) << "\".\n";
+      return false;
+    }
+
+    Job* job = FindJob(it->first);
+    if (job != NULL && job->exclusive) {
+      cout << "ERROR: Database \"" << it->first << "\" is in use by job [" << job->id << "].\n";
+      return false;
+    }
+    db[i] = &it->second;
+    field[i] = sides[i].substr(dot + 1);
+  }
+
+  int joined = db[0]->join(cout, field[0], db[0]->numSelected() ? SelectedRecords : AllRecords,
+                           *db[1], field[1], db[1]->numSelected() ? SelectedRecords : AllRecords);
+  cout << "Joined " << joined << " records.\n";
+  return false;
+}
+
 static struct { 
   DBSelectOperation type; 
   const char *name; 
@@ -310,31 +1303,35 @@ static struct {
  * the operation (all, clear, add, remove, refine) and if one of
  * the last three we hand over to the criteria processing function.
  * If the args are ill-formed, we report an error and leave selection
- * unchanged.
+ * unchanged. Criteria can be matched by a background job, leaving the
+ * selection unchanged if it is cancelled; all and clear are immediate.
  */
 
-template <typename value> bool SelectCommand(Database<value>& db)
+static DBSelectOperation isSelectOperation(const string &arg)
 {
-  string arg = GetNextToken();
-  DBSelectOperation type = (DBSelectOperation)-1;
-  
-  if (arg == "") { PrintHelpFile("help_select"); return false;};
-  
   for (int i = 0; selectCmds[i].name != NULL ; i++) {
     if ((int(arg.length()) >= selectCmds[i].minChars) && 
-	(strncmp(arg.c_str(), selectCmds[i].name, int(arg.length())) == 0)) {
-      type = selectCmds[i].type;
-      break;
-    }
+	(strncmp(arg.c_str(), selectCmds[i].name, int(arg.length())) == 0))
+      return selectCmds[i].type;
   }
+
+  return (DBSelectOperation)-1;
+}
+
+template <typename value> bool SelectCommand(Database<value>& db, const string& name)
+{
+  string arg = GetNextToken();
+  
+  if (arg == "") { PrintHelpFile("help_select"); return false;};
   
+  DBSelectOperation type = isSelectOperation(arg);
   switch (type) {
   case All:	
     db.selectAll(); return true;
   case Clear: 	
     db.deselectAll(); return true;
   case Add: case Remove: case Refine:
-    return SelectWithCriteria(type, db);
+    return SelectWithCriteria(type, db, name);
   default:
     cout << "ERROR: Invalid arguments to select command.\n";
   }
@@ -350,7 +1347,8 @@ static struct {
     { NotEqual,  "!="},
       { LessThan, "<"},
 	{ GreaterThan, ">"},
-	  {}
+	  { Contains, "^"},
+	    {}
 };
 
 static DBQueryOperator isQuery(const string &arg)
@@ -363,14 +1361,21 @@ static DBQueryOperator isQuery(const string &arg)
   return (DBQueryOperator)-1;
 }
 
-template <typename value> bool SelectWithCriteria(DBSelectOperation type, Database<value>& db)
+/* GetCriteria
+ * -----------
+ * Reads the criteria <fieldname> <op> <value> from the rest of the line,
+ * as given to select add, remove and refine. If the criteria are
+ * missing the help file is printed, if ill-formed an error is reported.
+ */
+
+template <typename value> bool GetCriteria(string& fieldname, DBQueryOperator& op, value& val)
 {
   string arg = GetNextToken();
-  DBQueryOperator op = (DBQueryOperator)-1;
+  op = (DBQueryOperator)-1;
   
   if (arg == "") { PrintHelpFile("help_criteria"); return false;};
   
-  string fieldname = arg;
+  fieldname = arg;
   while (true) {
     string arg = GetNextToken();
     if (arg == "") { // got to end of line without query op
@@ -384,12 +1389,95 @@ template <typename value> bool SelectWithCriteria(DBSelectOperation type, Databa
   }
 
   TrimString(fieldname);
-  value val;
   GetCriteriaValue(val);
-  db.select(type, fieldname, op, val);
   return true;
 }
 
+template <typename value> bool SelectWithCriteria(DBSelectOperation type, Database<value>& db, const string& name)
+{
+  string fieldname;
+  DBQueryOperator op;
+  value val;
+  if (!GetCriteria(fieldname, op, val))
+    return false;
+
+  if (!background) {
+    db.select(type, fieldname, op, val);
+    WarnSelectBudget(db);
+    return true;
+  }
+
+  //The database is left alone until the job finishes, so the job can use it directly
+  Job& job = StartJob(name, true);
+  job.complete = [&db, name]() {
+    cout << name << ": " << db.numRecords() << " records (" << db.numSelected() << " selected)\n";
+    WarnSelectBudget(db);
+  };
+  job.worker = thread([&job, &db, type, fieldname, op, val]() {
+    db.setProgress(&job.progress);
+    db.select(type, fieldname, op, val);
+    db.setProgress(NULL);
+    job.succeeded = true;
+    job.finished = true;
+  });
+  return false;
+}
+
+/* EstimateCommand
+ * ---------------
+ * When estimate is chosen.  Takes a select add, remove or refine
+ * command and, without running it, reports roughly how many records
+ * it would change and how many would then be selected.  The answer
+ * comes from a fixed size sample of the records, so it takes the same
+ * short time however large the database is.
+ */
+
+template <typename value> bool EstimateCommand(Database<value>& db)
+{
+  string arg = GetNextToken();
+  if (arg == "" || strncmp(arg.c_str(), "select", arg.length()) != 0) {
+    cout << "ERROR: estimate requires a select command, such as \"estimate select add <criteria>\".\n";
+    return false;
+  }
+
+  DBSelectOperation type = isSelectOperation(GetNextToken());
+  if (type != Add && type != Remove && type != Refine) {
+    cout << "ERROR: Only select add, remove and refine can be estimated.\n";
+    return false;
+  }
+
+  string fieldname;
+  DBQueryOperator op;
+  value val;
+  if (!GetCriteria(fieldname, op, val))
+    return false;
+
+  DBEstimate estimate = db.estimateSelect(type, fieldname, op, val);
+  const char *operation = type == Add ? "add" : type == Remove ? "remove" : "refine";
+  const char *change = type == Add ? "add" : "remove";
+  const char *kind = type == Add ? "unselected" : "selected";
+
+  long long records = llround(estimate.records);
+  long long selected = type == Add ? db.numSelected() + records : db.numSelected() - records;
+  if (estimate.low == estimate.high) {
+    cout << "select " << operation << " would " << change << " exactly " << records
+         << " records, leaving " << selected << " selected.\n";
+    return false;
+  }
+
+  if (estimate.sampled == 0) {
+    cout << "No " << kind << " records are sampled, select " << operation << " could "
+         << change << " anywhere from 0 to " << llround(estimate.high) << " records.\n";
+    return false;
+  }
+
+  cout << "select " << operation << " would " << change << " about " << records << " records ("
+       << llround(estimate.low) << " to " << llround(estimate.high) << " with 95% confidence), leaving about "
+       << selected << " selected.\n";
+  cout << "Estimated from " << estimate.hits << " of " << estimate.sampled << " sampled " << kind << " records.\n";
+  return false;
+}
+
 /* PrintHelpFile
  * -------------
  * Just opens a text file and echos its contents to the terminal.  It's 
@@ -437,6 +1525,7 @@ static void PrintMenuOptions()
  */
 
 static istringstream *istr = NULL;	// keep stream around between calls
+static string commandline;		// line istr scans, static since str uses it
 
 /* 
  * InitCommandLine
@@ -446,12 +1535,17 @@ static istringstream *istr = NULL;	// keep stream around between calls
  * through it.  Pulling it in one line at a time avoids weird
  * interactions between one command and the next, especially when
  * something went wrong parsing the earlier line.
+ * A trailing "&" is taken off the line and asks for a background job.
  */
 
 static void InitCommandLine()
 {
-  static string commandline;  // static since str uses it
   getline(cin, commandline);  // get line from user
+
+  size_t last = commandline.find_last_not_of(" \t\r");
+  background = last != string::npos && last > 0 && commandline[last] == '&' && isspace(commandline[last - 1]);
+  if (background) commandline.erase(last);
+
   delete istr;
   istr = new istringstream(commandline.c_str()); // start new stream up
 }
@@ -481,6 +1575,17 @@ void GetCriteriaValue(string& val)
   val = GetNextToken(false);
 }
 
+/* GetCriteriaValue
+ * ----------------
+ * Typed values take the rest of the line too, read as the narrowest
+ * type that writes it back unchanged, as values read from a file are.
+ */
+
+void GetCriteriaValue(TypedValue& val)
+{
+  val.assign(GetNextToken(false));
+}
+
 /* GetNextToken
  * ------------
  * Reads the next string token from the command line strstream.
@@ -526,3 +1631,182 @@ static CommandT GetCommandFromUser()
     cout <<"ERROR: \"" << command <<"\" is not a valid option.\n\n";
   }
 }
+
+/* StartJob
+ * --------
+ * Registers a job for the command line being run, on the named
+ * database. The caller sets complete and starts the worker, which
+ * must set finished last.
+ */
+
+static Job& StartJob(const string& database, bool exclusive)
+{
+  static unsigned nextId = 1;
+
+  string command = commandline;
+  TrimString(command);
+  unique_ptr<Job>& job = jobs[nextId];
+  job.reset(new Job(nextId++, database, command, exclusive));
+
+  cout << "[" << job->id << "] " << job->command << "\n";
+  return *job;
+}
+
+/* FindJob
+ * -------
+ * The job working on the named database, NULL if there is none.
+ * A database has at most one job at a time.
+ */
+
+static Job* FindJob(const string& database)
+{
+  for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+    if (it->second->database == database)
+      return it->second.get();
+  }
+  return NULL;
+}
+
+/* PrintCounts
+ * -----------
+ * Prints the number of records and selected records of the named
+ * database, or that it is busy while a job selecting on it may
+ * still be changing them.
+ */
+
+template <typename value> void PrintCounts(const string& name, const Database<value>& db)
+{
+  Job* job = FindJob(name);
+  if (job != NULL && job->exclusive) {
+    cout << "busy with job [" << job->id << "]";
+    return;
+  }
+  cout << db.numRecords() << " records (" << db.numSelected() << " selected)";
+}
+
+/* ReapJobs
+ * --------
+ * Reports every finished job with its messages and applies its
+ * result, unless it was cancelled or failed. Cancelled jobs have
+ * no result, only how far they got is reported.
+ */
+
+static void ReapJobs()
+{
+  for (auto it = jobs.begin(); it != jobs.end(); ) {
+    Job& job = *it->second;
+    if (!job.finished) {
+      ++it;
+      continue;
+    }
+
+    job.worker.join();
+    if (job.progress.cancel) {
+      cout << "[" << job.id << "] Cancelled\t" << job.command << " (after " << job.progress.processed << " records)\n";
+    }
+    else {
+      cout << "[" << job.id << "] " << (job.succeeded ? "Done" : "Failed") << "\t" << job.command << "\n" << job.output.str();
+      if (job.succeeded)
+        job.complete();
+    }
+    it = jobs.erase(it);
+  }
+}
+
+/* PrintJobProgress
+ * ----------------
+ * One line with the records a job has processed and its rate so far.
+ */
+
+static void PrintJobProgress(const Job& job)
+{
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - job.started).count();
+  size_t processed = job.progress.processed;
+
+  cout << "[" << job.id << "] " << (job.progress.cancel ? "Cancelling" : "Running") << "\t"
+       << job.database << ": " << job.command << "\t" << processed << " records";
+  if (seconds > 0)
+    cout << ", " << size_t(processed / seconds) << " records/s";
+  cout << "\n";
+}
+
+/* JobsCommand
+ * -----------
+ * When jobs is chosen.  Lists the background jobs with their progress.
+ */
+
+static bool JobsCommand()
+{
+  ReapJobs();
+  if (jobs.empty())
+    cout << "No background jobs.\n";
+
+  for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+    PrintJobProgress(*it->second);
+  }
+  return false;
+}
+
+/* WaitCommand
+ * -----------
+ * When wait is chosen.  Waits for the job whose number is given, or
+ * for every job, printing their progress once a second meanwhile.
+ */
+
+static bool WaitCommand()
+{
+  string arg = GetNextToken();
+  unsigned id = 0;
+  if (arg != "") {
+    istringstream idStream(arg);
+    if (!(idStream >> id) || jobs.count(id) == 0) {
+      cout << "ERROR: No background job [" << arg << "].\n";
+      return false;
+    }
+  }
+
+  auto waiting = [id]() {
+    for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+      if ((id == 0 || it->first == id) && !it->second->finished)
+        return true;
+    }
+    return false;
+  };
+
+  auto lastReport = chrono::steady_clock::now();
+  while (waiting()) {
+    this_thread::sleep_for(chrono::milliseconds(20));
+    if (chrono::steady_clock::now() - lastReport < chrono::seconds(1))
+      continue;
+
+    lastReport = chrono::steady_clock::now();
+    for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+      if ((id == 0 || it->first == id) && !it->second->finished)
+        PrintJobProgress(*it->second);
+    }
+  }
+
+  ReapJobs();
+  return false;
+}
+
+/* CancelCommand
+ * -------------
+ * When cancel is chosen.  Asks the job whose number is given to stop,
+ * it is reported as cancelled once it has.
+ */
+
+static bool CancelCommand()
+{
+  string arg = GetNextToken();
+  istringstream idStream(arg);
+  unsigned id;
+  if (!(idStream >> id) || jobs.count(id) == 0) {
+    cout << "ERROR: Cancel requires the number of a background job.\n";
+    return false;
+  }
+
+  jobs[id]->progress.cancel = true;
+  cout << "Cancelling job [" << id << "].\n";
+  return false;
+}
@@ -0,0 +1,57 @@
+// MappedFile implementation
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mappedfile.h"
+
+/*
+* Map filename into memory, replacing any previous mapping.
+* The kernel is told the mapping will be read sequentially so it reads ahead aggressively.
+*
+* Complexity: O(1), pages are only read when touched
+* Return: false if the file can not be opened or mapped
+*/
+bool MappedFile::open(const string& filename) {
+  close();
+
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    ::close(fd);
+    return false;
+  }
+
+  //An empty file is valid but can not be mapped
+  if (st.st_size > 0) {
+    void* p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      ::close(fd);
+      return false;
+    }
+
+    madvise(p, st.st_size, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(p);
+    size_ = st.st_size;
+  }
+
+  //The mapping stays valid after the descriptor is closed
+  ::close(fd);
+  return true;
+}
+
+/*
+* Release the mapping, any pointers into it become invalid.
+* Complexity: O(1)
+*/
+void MappedFile::close() {
+  if (data_ != NULL)
+    munmap(const_cast<char*>(data_), size_);
+
+  data_ = NULL;
+  size_ = 0;
+}
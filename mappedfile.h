@@ -0,0 +1,44 @@
+/**
+*  Read only memory mapping of a whole file.
+*
+*  Used by lazily read databases, whose records point straight into the
+*  mapped text instead of keeping their own copy of it.
+*
+*  Author: Mohammad Ghasembeigi
+*
+*/
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+
+using namespace std;
+
+class MappedFile {
+public:
+  //Default constructor
+  MappedFile() : data_(NULL), size_(0) {}
+
+  //Member functions
+  bool open(const string& filename);
+  void close();
+
+  //Complexity of inlines: O(1)
+  inline const char* data() const { return data_; }
+  inline size_t size() const { return size_; }
+
+  //Unmaps the file
+  ~MappedFile() { close(); }
+
+private:
+  const char* data_;
+  size_t size_;
+
+  //Mappings are owned by exactly one object
+  MappedFile(const MappedFile&);
+  MappedFile& operator=(const MappedFile&);
+
+};
+
+#endif
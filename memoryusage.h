@@ -0,0 +1,57 @@
+/**
+*  Estimates of the heap memory held by standard containers, used for memory accounting.
+*
+*  Only memory allocated by a container is counted, not the container object itself,
+*  which is counted as part of whatever holds it. Estimates follow libstdc++: strings
+*  keep short text inside the object, hash tables hold an array of buckets and one node
+*  per element with a link to the next node. Each allocation is rounded up the way glibc
+*  malloc does, to a chunk of at least 32 bytes holding the size in front of the memory.
+*
+*  Author: Mohammad Ghasembeigi
+*
+*/
+
+#ifndef MEMORYUSAGE_H
+#define MEMORYUSAGE_H
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//Heap memory taken by an allocation of bytes
+inline size_t allocationBytes(size_t bytes) {
+  if (bytes == 0)
+    return 0;
+  size_t chunk = (bytes + sizeof(size_t) + 15) & ~size_t(15);
+  return chunk < 32 ? 32 : chunk;
+}
+
+//Text held outside a string, short strings keep theirs inside the object
+inline size_t stringBytes(const string& s) {
+  const char* inside = reinterpret_cast<const char*>(&s);
+  bool local = s.data() >= inside && s.data() < inside + sizeof(s);
+  return local ? 0 : allocationBytes(s.capacity() + 1);
+}
+
+//Heap memory held by a value, only strings have any
+template <class value>
+inline size_t valueBytes(const value&) { return 0; }
+
+inline size_t valueBytes(const string& val) { return stringBytes(val); }
+
+//Storage of a vector, not counting memory its elements hold themselves
+template <class T>
+inline size_t vectorBytes(const vector<T>& v) { return allocationBytes(v.capacity() * sizeof(T)); }
+
+inline size_t vectorBytes(const vector<bool>& v) { return allocationBytes((v.capacity() + 7) / 8); }
+
+//Buckets and nodes of an unordered_map or unordered_set, not counting memory its elements hold themselves
+template <class Table>
+inline size_t hashTableBytes(const Table& t) {
+  //A table with a single bucket keeps it inside the object
+  size_t buckets = t.bucket_count() > 1 ? allocationBytes(t.bucket_count() * sizeof(void*)) : 0;
+  return buckets + t.size() * allocationBytes(sizeof(void*) + sizeof(typename Table::value_type));
+}
+
+#endif
@@ -0,0 +1,135 @@
+// PagedStore implementation
+
+#include "pagedstore.h"
+
+/*
+* Start an empty store whose pages are cached in at most budgetBytes of memory.
+* Complexity: O(1)
+* Return: false if the scratch file could not be created
+*/
+bool PagedStore::open(size_t budgetBytes) {
+  bytes = 0;
+  count = 0;
+  checkpoints.clear();
+  return pool.open(budgetBytes);
+}
+
+/*
+* Append a record's text to the end of the stream.
+* Complexity: O(k) where k is the length of text
+* Return: false if the record could not be stored, the store has then failed
+*/
+bool PagedStore::append(const string& text) {
+  if (count % CheckpointInterval == 0)
+    checkpoints.push_back(bytes);
+
+  uint32_t length = text.length();
+  bool stored = pool.write(bytes, reinterpret_cast<const char*>(&length), sizeof(length))
+             && pool.write(bytes + sizeof(length), text.data(), length);
+
+  bytes += sizeof(length) + length;
+  ++count;
+  return stored;
+}
+
+/*
+* Remove every record whose keep bit is false.
+* Kept records are copied towards the front of the stream in place, which is safe as
+* the write position never passes the read position, so this is a single sequential pass.
+*
+* Complexity: O(b) where b is the size of the stream
+* Return: false if the scratch file failed, the store has then failed and its records are lost
+*/
+bool PagedStore::compact(const vector<bool>& keep) {
+  size_t readOffset = 0, writeOffset = 0, kept = 0;
+  string text;
+  checkpoints.clear();
+
+  for (size_t index = 0; index < count; ++index) {
+    uint32_t length;
+    if (!pool.read(readOffset, reinterpret_cast<char*>(&length), sizeof(length)))
+      return false;
+    size_t total = sizeof(length) + length;
+
+    if (keep[index]) {
+      if (kept % CheckpointInterval == 0)
+        checkpoints.push_back(writeOffset);
+
+      if (writeOffset != readOffset) {
+        text.resize(total);
+        if (!pool.read(readOffset, &text[0], total) || !pool.write(writeOffset, text.data(), total))
+          return false;
+      }
+      writeOffset += total;
+      ++kept;
+    }
+
+    readOffset += total;
+  }
+
+  bytes = writeOffset;
+  count = kept;
+  return true;
+}
+
+
+// PagedStore::Cursor
+
+/*
+* Complexity: O(k) where k is the length of the record
+*/
+bool PagedStore::Cursor::next(string& text) {
+  if (index >= store.count)
+    return false;
+
+  uint32_t length;
+  if (!store.pool.read(offset, reinterpret_cast<char*>(&length), sizeof(length)))
+    return false;
+  text.resize(length);
+  if (length > 0 && !store.pool.read(offset + sizeof(length), &text[0], length))
+    return false;
+
+  offset += sizeof(length) + length;
+  ++index;
+  return true;
+}
+
+/*
+* Complexity: O(1), only the length prefix is read
+*/
+bool PagedStore::Cursor::skip() {
+  if (index >= store.count)
+    return false;
+
+  uint32_t length;
+  if (!store.pool.read(offset, reinterpret_cast<char*>(&length), sizeof(length)))
+    return false;
+
+  offset += sizeof(length) + length;
+  ++index;
+  return true;
+}
+
+/*
+* Jump to the last checkpoint at or before index when that is ahead, then skip the rest of the way.
+* Complexity: O(CheckpointInterval), only length prefixes are read
+* Return: false if there is no record at index or the store failed
+*/
+bool PagedStore::Cursor::seek(size_t target) {
+  if (target >= store.count) {
+    index = store.count;
+    return false;
+  }
+
+  size_t checkpoint = target / CheckpointInterval;
+  if (checkpoint * CheckpointInterval > index) {
+    index = checkpoint * CheckpointInterval;
+    offset = store.checkpoints[checkpoint];
+  }
+
+  while (index < target) {
+    if (!skip())
+      return false;
+  }
+  return true;
+}
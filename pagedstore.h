@@ -0,0 +1,79 @@
+/**
+*  Disk backed record storage for databases larger than memory.
+*
+*  Records are kept as their text in a byte stream laid over the pages of a
+*  BufferPool, each record prefixed by its length. Only the pages the pool
+*  has room for are ever in memory, everything else stays in the scratch file.
+*  Records are only ever visited in order, so all access is sequential.
+*  Once the scratch file fails appends fail and cursors find no more records.
+*
+*  Author: Mohammad Ghasembeigi
+*
+*/
+
+#ifndef PAGEDSTORE_H
+#define PAGEDSTORE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+#include "bufferpool.h"
+
+class PagedStore {
+public:
+  //Default constructor
+  PagedStore() : pool(), bytes(0), count(0), checkpoints(vector<size_t>()) {}
+
+  //The offset of every CheckpointInterval'th record is remembered so cursors can seek
+  static const size_t CheckpointInterval = 1024;
+
+  //Member functions
+  bool open(size_t budgetBytes);
+  bool append(const string& text);
+  bool compact(const vector<bool>& keep);
+
+  //Complexity of inlines: O(1)
+  inline size_t size() const { return count; }
+  inline size_t sizeBytes() const { return bytes; }
+  inline bool good() const { return pool.good(); }
+  inline const BufferPool& buffers() const { return pool; }
+
+  /* Cursor
+  * ------
+  * Reads the records of a store front to back, the store must not change while reading.
+  */
+  class Cursor {
+  public:
+    Cursor(const PagedStore& store) : store(store), offset(0), index(0) {}
+
+    //Read the next record into text, false once every record has been read or the store failed
+    bool next(string& text);
+
+    //Skip the next record without copying it, false once every record has been read or the store failed
+    bool skip();
+
+    //Move forward so the next record read is the one at index, false if there is no such record or the store failed
+    bool seek(size_t index);
+
+  private:
+    const PagedStore& store;
+    size_t offset;
+    size_t index;
+  };
+
+  //Default Destructor
+  ~PagedStore() {};
+
+private:
+  //Reading through the pool updates its cache, which does not change the stored records
+  mutable BufferPool pool;
+  size_t bytes;   //length of the record stream
+  size_t count;   //number of records in the stream
+  vector<size_t> checkpoints;   //offset of records 0, CheckpointInterval, 2 * CheckpointInterval, ...
+
+};
+
+#endif
@@ -0,0 +1,107 @@
+// QueryCache implementation
+
+#include "querycache.h"
+
+/*
+* Look up the matches of a query, counting the hit or miss.
+* Entries computed at another version are stale, so the whole cache is dropped.
+*
+* Complexity: O(k) where k is the length of key
+* Return: the cached matches, valid until the next insert or clear, NULL if not cached
+*/
+const vector<bool>* QueryCache::find(const string& key, unsigned long atVersion) {
+  if (atVersion != version) {
+    clear();
+    version = atVersion;
+  }
+
+  auto it = entries.find(key);
+  if (it == entries.end()) {
+    ++misses;
+    return NULL;
+  }
+
+  //Mark as most recently used
+  recent.splice(recent.begin(), recent, it->second.age);
+  ++hits;
+  return &it->second.matches;
+}
+
+/*
+* Remember the matches of a query, evicting least recently used entries to make room.
+* Results larger than the whole budget are not cached.
+*
+* Complexity: O(n) in the number of matches
+*/
+void QueryCache::insert(const string& key, unsigned long atVersion, const vector<bool>& matches) {
+  if (atVersion != version) {
+    clear();
+    version = atVersion;
+  }
+
+  size_t needed = entryBytes(key, matches);
+  if (needed > budget || entries.count(key) > 0)
+    return;
+
+  evict(needed);
+
+  recent.push_front(key);
+  Entry& entry = entries[key];
+  entry.matches = matches;
+  entry.age = recent.begin();
+  bytes += needed;
+}
+
+/*
+* Drop every entry, hit and miss counts are kept.
+* Complexity: O(e) in the number of entries
+*/
+void QueryCache::clear() {
+  entries.clear();
+  recent.clear();
+  bytes = 0;
+}
+
+/*
+* Drop the entries of queries whose result depends on attr, after its values changed.
+* Complexity: O(e) in the number of entries
+*/
+void QueryCache::invalidate(const string& attr) {
+  //Keys start with the attribute and a newline
+  string prefix = attr + '\n';
+  string anyPrefix = "*\n";
+
+  for (auto it = recent.begin(); it != recent.end(); ) {
+    if (it->compare(0, prefix.length(), prefix) != 0 && it->compare(0, anyPrefix.length(), anyPrefix) != 0) {
+      ++it;
+      continue;
+    }
+
+    auto eit = entries.find(*it);
+    bytes -= entryBytes(eit->first, eit->second.matches);
+    entries.erase(eit);
+    it = recent.erase(it);
+  }
+}
+
+/*
+* Change the memory budget, evicting entries that no longer fit. A budget of 0 disables caching.
+* Complexity: O(e) in the number of entries evicted
+*/
+void QueryCache::setBudget(size_t budgetBytes) {
+  budget = budgetBytes;
+  evict(0);
+}
+
+/*
+* Evict least recently used entries until needed more bytes fit in the budget.
+* Complexity: O(e) in the number of entries evicted
+*/
+void QueryCache::evict(size_t needed) {
+  while (!recent.empty() && bytes + needed > budget) {
+    auto it = entries.find(recent.back());
+    bytes -= entryBytes(it->first, it->second.matches);
+    entries.erase(it);
+    recent.pop_back();
+  }
+}
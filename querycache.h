@@ -0,0 +1,76 @@
+/**
+*  Cache of select results, keyed by the query criteria.
+*
+*  Every entry is the bitmap of records that matched a query, one bit per
+*  record position. Entries are only valid for the database version they were
+*  computed at, so any change to the records empties the cache. The least
+*  recently used entries are evicted to stay within a memory budget.
+*
+*  Author: Mohammad Ghasembeigi
+*
+*/
+
+#ifndef QUERYCACHE_H
+#define QUERYCACHE_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+
+using namespace std;
+
+class QueryCache {
+public:
+  //Default constructor
+  QueryCache() : budget(DefaultBudget), bytes(0), version(0), hits(0), misses(0),
+                 entries(unordered_map<string, Entry>()), recent(list<string>()) {}
+
+  static const size_t DefaultBudget = 16 << 20;
+
+  //Member functions
+  const vector<bool>* find(const string& key, unsigned long atVersion);
+  void insert(const string& key, unsigned long atVersion, const vector<bool>& matches);
+  void clear();
+  void invalidate(const string& attr);
+  void setBudget(size_t budgetBytes);
+
+  //Key of the query attr op valueText, queries on "*" depend on every attribute
+  static inline string key(const string& attr, int op, const string& valueText) {
+    return attr + '\n' + char('0' + op) + '\n' + valueText;
+  }
+
+  //Complexity of inlines: O(1)
+  inline size_t size() const { return entries.size(); }
+  inline size_t sizeBytes() const { return bytes; }
+  inline size_t budgetBytes() const { return budget; }
+  inline size_t numHits() const { return hits; }
+  inline size_t numMisses() const { return misses; }
+
+  //Default Destructor
+  ~QueryCache() {};
+
+private:
+  struct Entry {
+    vector<bool> matches;
+    list<string>::iterator age;   //position in recent
+  };
+
+  size_t budget;
+  size_t bytes;           //approximate memory held by entries
+  unsigned long version;  //database version every entry was computed at
+  size_t hits;
+  size_t misses;
+
+  unordered_map<string, Entry> entries;
+  list<string> recent;    //keys, most recently used first
+
+  //Private helper functions
+  static inline size_t entryBytes(const string& key, const vector<bool>& matches) {
+    return key.length() + (matches.size() + 7) / 8;
+  }
+  void evict(size_t needed);
+
+};
+
+#endif
@@ -13,11 +13,13 @@
 #include <vector>
 
 #include <unordered_map>
-#include <list>
 
 using namespace std;
 
 #include "utility.h"
+#include "attribute.h"
+#include "memoryusage.h"
+#include "typedvalue.h"
 
 /* Database enums
 * --------------
@@ -29,7 +31,7 @@ using namespace std;
 
 enum DBSelectOperation { All, Clear, Add, Remove, Refine };
 enum DBScope { AllRecords, SelectedRecords };
-enum DBQueryOperator { Equal, NotEqual, LessThan, GreaterThan };
+enum DBQueryOperator { Equal, NotEqual, LessThan, GreaterThan, Contains };
 
 
 // Need to add declarations for operator<< and operator >> here
@@ -37,19 +39,77 @@ template <class value> class Record;
 template <class value> ostream& operator<<(ostream& out, const Record<value>& r);
 template <class value> istream& operator>>(istream& in, Record<value>& r);
 
+//Textual form of a value, used for substring ("^") matching and indexing
+template <class value> string valueText(const value& val);
+template <class value> bool valueContains(const value& val, const value& want);
+
+//Parse the text of a value, as it appears after " = " in a record
+template <class value> void parseValue(const char* text, value& val);
+
+//True if val is 'equivalent' to want under operation op
+template <class value> bool valueMatches(const value& val, DBQueryOperator op, const value& want);
+
+//True if any of the values of an attribute is 'equivalent' to want under operation op
+template <class value> bool anyValueMatches(const vector<value>& vals, DBQueryOperator op, const value& want);
+
 template <class value>
 class Record {
 
 public:
   //Default constructor
-  Record<value>() : selected(false), fields(unordered_map<string, vector<value>>()), insertionOrder(list<pair<string, size_t>>()) {};
+  Record<value>() : fields(unordered_map<Attribute, vector<value>>()), insertionOrder(vector<pair<Attribute, size_t>>()),
+                    raw(NULL), rawLength(0), unparsed(false) {};
+
+  //Records are moved rather than copied when the vector holding them grows
+  Record<value>(const Record<value>&) = default;
+  Record<value>(Record<value>&&) = default;
+  Record<value>& operator=(const Record<value>&) = default;
+  Record<value>& operator=(Record<value>&&) = default;
 
   //Member functions
-  inline bool isSelected() const { return selected; };
-  inline void setSelected(bool val) { selected = val; };
+
+  //Lazily read records only remember the text of their block, from "{" to "}" inclusive.
+  //The text must outlive the record, fields are parsed from it the first time they are needed
+  void setRaw(const char* text, size_t length);
+
+  //Parse a lazily read record now and forget its text, so the record no longer depends on it
+  void detach();
+
+  //False for a lazily read record whose fields have not been parsed yet. Complexity: O(1)
+  inline bool isParsed() const { return !unparsed; }
 
   //Main query matching command
   bool matchesQuery(const string& attr, DBQueryOperator op, const value& want) const;
+  bool matchesQuery(Attribute attr, DBQueryOperator op, const value& want) const;
+
+  //Add attr = val as the new last field
+  void addValue(Attribute attr, const value& val);
+
+  //Replace every value of attr with val, or add attr = val as a new last field if there is none
+  void setValues(Attribute attr, const value& val);
+
+  //Calls change(value) for every value of attr, which may modify it in place
+  template <class Visitor> void changeValues(Attribute attr, Visitor change);
+
+  //All values stored under attr, NULL if the record has no such field
+  const vector<value>* valuesOf(const string& attr) const;
+  const vector<value>* valuesOf(Attribute attr) const;
+
+  //Same format as <<, but only the fields named in attrs, in that order
+  void writeFields(ostream& out, const vector<Attribute>& attrs) const;
+
+  //Adds the memory the record holds outside of itself to fieldBytes, except the text of string values
+  //which is added to valueBytes. Lazily read records count nothing until they are parsed
+  void memoryUsage(size_t& fieldBytes, size_t& valueBytes) const;
+
+  //Number of fields, counting every value of an attribute
+  inline size_t numFields() const { ensureParsed(); return insertionOrder.size(); }
+
+  //Calls visit(attribute, value) for every field in insertion order
+  template <class Visitor> void forEachField(Visitor visit) const;
+
+  //Calls visit(attribute, values) once for every distinct attribute, in no particular order
+  template <class Visitor> void forEachAttribute(Visitor visit) const;
 
   //Operator overloads
   friend ostream& operator<<<value>(ostream& out, const Record<value>& r);
@@ -59,16 +119,24 @@ public:
   ~Record() {};
 
 private:
-  bool selected;  //used to select/unselect record
+  //Record data will be stored in an unordered_map which maps attributes to a vector of values
+  //This has many advantages over a vector of pairs at the cost of a little extra memory (as insertion order has to be kept separately)
+  //Attribute names are interned, so the map and insertion order only hold pointers to the shared names
+  //Both are mutable as lazily read records fill them in on first use
+  mutable unordered_map<Attribute, vector<value>> fields;
+  mutable vector<pair<Attribute, size_t>> insertionOrder;
 
-  //Record data will be stored in an unordered_map which maps strings to a vector of values
-  //This has many advantages over a vector of pairs at the cost of a little extra memory (as insertion order has to be kept in a list)
-  unordered_map<string, vector<value>> fields;
-  list<pair<string, size_t>> insertionOrder;
+  //Original text of a lazily read record, written back verbatim while the record is unmodified
+  const char* raw;
+  size_t rawLength;
+  mutable bool unparsed;  //true until fields have been parsed from raw
 
 
   //Private helper functions
-  void readValue(istream& is, value& val);
+  inline void ensureParsed() const { if (unparsed) parseRaw(); }
+  void parseRaw() const;
+  static void parseField(const string& line, Attribute& attr, value& val);
+  void storeFields(vector<pair<Attribute, value>>& parsed) const;
 
 };
 
@@ -0,0 +1,6 @@
+// Storage for the attribute lists of compile time schemas
+
+#include "schema.h"
+
+constexpr const char* InventorySchema::Names[];
+constexpr size_t InventorySchema::Size;
@@ -0,0 +1,41 @@
+/**
+*  Record schemas declared at compile time, used by FixedRecord.
+*
+*  A schema is a struct naming the value type of its records and listing, as a
+*  constexpr array, the attributes every record holds in the order they are written.
+*  schemaIndex resolves an attribute name to its position while compiling, so code
+*  that knows the attribute it wants never looks it up at run time.
+*
+*  Author: Mohammad Ghasembeigi
+*
+*/
+
+#ifndef SCHEMA_H
+#define SCHEMA_H
+
+#include <cstddef>
+
+using namespace std;
+
+//Compile time string comparison
+constexpr bool sameName(const char* a, const char* b) {
+  return *a == *b && (*a == '\0' || sameName(a + 1, b + 1));
+}
+
+//Position of name in Schema's attribute list, Schema::Size if it is not listed
+template <class Schema>
+constexpr size_t schemaIndex(const char* name, size_t i = 0) {
+  return i == Schema::Size || sameName(Schema::Names[i], name) ? i : schemaIndex<Schema>(name, i + 1);
+}
+
+/* InventorySchema
+* ---------------
+* Parts inventory, the layout of db_int.
+*/
+struct InventorySchema {
+  typedef int value;
+  static constexpr const char* Names[] = { "part number", "number in stock", "supplier cost", "retail cost" };
+  static constexpr size_t Size = sizeof(Names) / sizeof(Names[0]);
+};
+
+#endif
@@ -0,0 +1,81 @@
+// HyperLogLog sketch and sampling helpers that do not depend on the item type
+
+#include <cmath>
+#include <algorithm>
+#include "sketch.h"
+
+/*
+* Wilson score interval of the proportion hits / sampled, scaled to the population.
+* Sampling without replacement is allowed for by shrinking z by the finite population
+* correction, which reaches 0 once every item has been sampled.
+*
+* Complexity: O(1)
+*/
+void proportionInterval(size_t hits, size_t sampled, size_t population, double& low, double& high) {
+  if (sampled == 0) {
+    low = 0;
+    high = population;
+    return;
+  }
+
+  double n = sampled;
+  double p = hits / n;
+  double correction = sampled >= population ? 0.0 : sqrt(double(population - sampled) / (population - 1));
+  double z = 1.96 * correction;
+
+  double scale = 1.0 / (1.0 + z * z / n);
+  double center = (p + z * z / (2 * n)) * scale;
+  double spread = z * scale * sqrt(p * (1 - p) / n + z * z / (4 * n * n));
+
+  low = max(0.0, center - spread) * population;
+  high = min(1.0, center + spread) * population;
+}
+
+/*
+* Add the hash of a value.
+* Complexity: O(1)
+*/
+void HyperLogLog::add(uint64_t hash) {
+  size_t index = hash >> (64 - Precision);
+
+  //The low bit stops the count at the bits that remain, as if a 1 followed them
+  uint64_t rest = (hash << Precision) | (uint64_t(1) << (Precision - 1));
+  uint8_t rank = uint8_t(__builtin_clzll(rest) + 1);
+
+  if (rank > registers[index])
+    registers[index] = rank;
+}
+
+/*
+* Combine with a sketch of other values, as if every value of other had been added here.
+* Complexity: O(Registers)
+*/
+void HyperLogLog::merge(const HyperLogLog& other) {
+  for (size_t i = 0; i < Registers; ++i) {
+    registers[i] = max(registers[i], other.registers[i]);
+  }
+}
+
+/*
+* Estimate the number of distinct values added, from the harmonic mean of the registers.
+* While many registers are still empty linear counting of the empty ones is more accurate.
+* Hashes are 64 bits, so no correction is needed for collisions at large counts.
+*
+* Complexity: O(Registers)
+* Return: estimated number of distinct values, 0 for an empty sketch
+*/
+double HyperLogLog::estimate() const {
+  double sum = 0;
+  size_t empty = 0;
+  for (size_t i = 0; i < Registers; ++i) {
+    sum += ldexp(1.0, -registers[i]);
+    if (registers[i] == 0)
+      ++empty;
+  }
+
+  double m = Registers;
+  double raw = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+  if (raw <= 2.5 * m && empty > 0)
+    return m * log(m / empty);
+  return raw;
+}
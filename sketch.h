@@ -0,0 +1,111 @@
+/**
+*  Fixed size summaries of the records, used to answer approximate questions without a scan.
+*
+*  A ReservoirSample keeps a uniform random sample of a stream of items whose length is not
+*  known in advance, replacing sampled items as later ones arrive so every item seen so far
+*  is equally likely to be in the sample. A HyperLogLog sketch estimates the number of
+*  distinct values added to it from the longest run of leading zero bits in their hashes,
+*  kept per bucket. Both take the same memory however many items they have seen.
+*
+*  Author: Mohammad Ghasembeigi
+*
+*/
+
+#ifndef SKETCH_H
+#define SKETCH_H
+
+#include <vector>
+#include <random>
+#include <functional>
+#include <cstdint>
+
+using namespace std;
+
+//Bounds on the number of items of a population of population that have some property, given
+//that hits of sampled items drawn uniformly without replacement have it. The Wilson score
+//interval at 95% confidence, narrowed to a single number when the sample is the whole population
+void proportionInterval(size_t hits, size_t sampled, size_t population, double& low, double& high);
+
+//Well mixed 64 bit hash of a value, std::hash of an int is the int itself
+template <class value>
+inline uint64_t sketchHash(const value& val) {
+  uint64_t h = hash<value>()(val);
+  h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+  h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+  return h ^ (h >> 31);
+}
+
+/* ReservoirSample
+* ---------------
+* Offer every item of the stream in turn. Until the sample is full every item is taken, after
+* that the gap to the next item taken is drawn directly (Li's algorithm L), so items that are
+* skipped cost a comparison rather than a random number.
+*/
+template <class T>
+class ReservoirSample {
+public:
+  //Constructor, the seed is fixed by default so the same stream always gives the same sample
+  ReservoirSample<T>(size_t capacity, uint64_t seed = 0x5EED) : capacity(capacity), items(vector<T>()), seen(0), next(0),
+                                                                 weight(1.0), random(seed) {}
+
+  //Member functions
+  T* offer();
+  void clear();
+
+  //Complexity of inlines: O(1)
+  inline size_t size() const { return items.size(); }
+  inline size_t numSeen() const { return seen; }
+  inline typename vector<T>::iterator begin() { return items.begin(); }
+  inline typename vector<T>::iterator end() { return items.end(); }
+  inline typename vector<T>::const_iterator begin() const { return items.begin(); }
+  inline typename vector<T>::const_iterator end() const { return items.end(); }
+
+  //Default Destructor
+  ~ReservoirSample() {};
+
+private:
+  size_t capacity;
+  vector<T> items;
+  size_t seen;      //number of items offered
+  size_t next;      //position in the stream of the next item to take once full
+  double weight;    //largest of capacity uniform random keys, as algorithm L keeps it
+  mt19937_64 random;
+
+  //Private helper functions
+  double uniform();
+  void skip(size_t position);
+
+};
+
+/* HyperLogLog
+* -----------
+* 2^Precision one byte registers, the first Precision bits of a hash pick the register and
+* it keeps the largest rank (position of the first set bit) of the remaining bits.
+*/
+class HyperLogLog {
+public:
+  //Default constructor
+  HyperLogLog() : registers(vector<uint8_t>(Registers, 0)) {}
+
+  static const unsigned Precision = 12;
+  static const size_t Registers = size_t(1) << Precision;
+
+  //Member functions
+  void add(uint64_t hash);
+  void merge(const HyperLogLog& other);
+  double estimate() const;
+
+  //Relative standard error of estimates, 1.04 / sqrt(Registers)
+  static inline double standardError() { return 1.04 / (1 << (Precision / 2)); }
+
+  //Default Destructor
+  ~HyperLogLog() {};
+
+private:
+  vector<uint8_t> registers;
+
+};
+
+#include "sketch.tem"
+
+#endif
@@ -0,0 +1,112 @@
+// TrigramIndex implementation
+
+#include <algorithm>
+#include <iterator>
+#include "trigram.h"
+#include "memoryusage.h"
+
+/*
+* Remove all postings, releasing the table so a dropped index frees its memory.
+* Complexity: O(n) in the number of postings
+*/
+void TrigramIndex::clear() {
+  unordered_map<uint32_t, vector<unsigned>>().swap(postings);
+  numIds = 0;
+}
+
+/*
+* Index text for the given id.
+* Ids must be added in non-decreasing order so posting lists stay sorted, the
+* same id may be added several times (once per value of a record).
+*
+* Complexity: O(k) where k is the length of text
+*/
+void TrigramIndex::add(unsigned id, const string& text) {
+  if (text.length() < MinPatternLength)
+    return;
+
+  const char* p = text.data();
+  for (size_t i = 0; i + MinPatternLength <= text.length(); ++i) {
+    vector<unsigned>& list = postings[gram(p + i)];
+
+    //Only record an id once per trigram
+    if (list.empty() || list.back() != id) {
+      list.push_back(id);
+      ++numIds;
+    }
+  }
+}
+
+/*
+* Index the same text for many ids at once, in any position relative to ids already indexed.
+* ids must be ascending. Each posting list of text is merged with ids once.
+*
+* Complexity: O(k * (m + s)) where k is the length of text, m the length of its posting lists
+*             and s the number of ids
+*/
+void TrigramIndex::addAll(const vector<unsigned>& ids, const string& text) {
+  if (text.length() < MinPatternLength || ids.empty())
+    return;
+
+  vector<uint32_t> grams;
+  const char* p = text.data();
+  for (size_t i = 0; i + MinPatternLength <= text.length(); ++i) {
+    grams.push_back(gram(p + i));
+  }
+  sort(grams.begin(), grams.end());
+  grams.erase(unique(grams.begin(), grams.end()), grams.end());
+
+  vector<unsigned> merged;
+  for (auto git = grams.begin(); git != grams.end(); ++git) {
+    vector<unsigned>& list = postings[*git];
+    merged.clear();
+    set_union(list.begin(), list.end(), ids.begin(), ids.end(), back_inserter(merged));
+    numIds += merged.size() - list.size();
+    list.swap(merged);
+  }
+}
+
+/*
+* Complexity: O(1)
+*/
+size_t TrigramIndex::memoryUsage() const {
+  return hashTableBytes(postings) + numIds * sizeof(unsigned);
+}
+
+/*
+* Fill out with the ascending ids of every text that may contain pattern.
+* Return: false if pattern is too short to be narrowed by the index, in which case out is untouched
+*
+* Complexity: O(k * m) where k is the number of distinct trigrams in pattern and m the shortest posting list
+*/
+bool TrigramIndex::candidates(const string& pattern, vector<unsigned>& out) const {
+  if (pattern.length() < MinPatternLength)
+    return false;
+
+  out.clear();
+
+  //Gather the posting list of every distinct trigram, any missing trigram means no candidates at all
+  vector<const vector<unsigned>*> lists;
+  const char* p = pattern.data();
+  for (size_t i = 0; i + MinPatternLength <= pattern.length(); ++i) {
+    auto it = postings.find(gram(p + i));
+    if (it == postings.end())
+      return true;
+
+    if (find(lists.begin(), lists.end(), &it->second) == lists.end())
+      lists.push_back(&it->second);
+  }
+
+  //Intersect starting from the shortest list so intermediate results stay small
+  sort(lists.begin(), lists.end(), [](const vector<unsigned>* a, const vector<unsigned>* b) { return a->size() < b->size(); });
+
+  out = *lists.front();
+  vector<unsigned> next;
+  for (size_t i = 1; i < lists.size() && !out.empty(); ++i) {
+    next.clear();
+    set_intersection(out.begin(), out.end(), lists[i]->begin(), lists[i]->end(), back_inserter(next));
+    out.swap(next);
+  }
+
+  return true;
+}
@@ -0,0 +1,59 @@
+/**
+*  Trigram (3-gram) index used to narrow substring searches ("^" queries).
+*
+*  Every indexed text is split into overlapping 3 character windows and the
+*  id of its owner is recorded against each window. A pattern can only occur
+*  in a text that contains every trigram of the pattern, so intersecting the
+*  posting lists of the pattern's trigrams gives a (usually small) candidate
+*  set which is then verified with an exact match.
+*
+*  Author: Mohammad Ghasembeigi
+*
+*/
+
+#ifndef TRIGRAM_H
+#define TRIGRAM_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+using namespace std;
+
+class TrigramIndex {
+public:
+  //Default constructor
+  TrigramIndex() : postings(unordered_map<uint32_t, vector<unsigned>>()), numIds(0) {}
+
+  //Patterns shorter than this contain no trigram and can not be narrowed
+  static const size_t MinPatternLength = 3;
+
+  //Member functions
+  void clear();
+  void add(unsigned id, const string& text);
+  void addAll(const vector<unsigned>& ids, const string& text);
+  bool candidates(const string& pattern, vector<unsigned>& out) const;
+
+  //Complexity of inlines: O(1)
+  inline bool empty() const { return postings.empty(); }
+
+  //Memory held by the postings, as if every list were exactly as long as it is
+  size_t memoryUsage() const;
+
+  //Default Destructor
+  ~TrigramIndex() {};
+
+private:
+  //Maps a packed trigram to the ascending list of ids whose text contains it
+  unordered_map<uint32_t, vector<unsigned>> postings;
+  size_t numIds;  //total length of the posting lists
+
+  //Pack 3 characters into a single key
+  static inline uint32_t gram(const char* p) {
+    return (uint32_t(uint8_t(p[0])) << 16) | (uint32_t(uint8_t(p[1])) << 8) | uint32_t(uint8_t(p[2]));
+  }
+
+};
+
+#endif
@@ -0,0 +1,274 @@
+// TypedValue implementation
+
+#include <climits>
+#include <sstream>
+#include "typedvalue.h"
+
+namespace {
+  long long GCD(long long x, long long y) {
+    while (y != 0) {
+      long long t = x % y;
+      x = y;
+      y = t;
+    }
+    return x;
+  }
+}
+
+TypedValue::TypedValue(const Fraction& val) : type_(FractionValue) {
+  number.numerator = val.Numerator();
+  number.denominator = val.Denominator();
+}
+
+TypedValue::TypedValue(const TypedValue& other) : type_(other.type_) {
+  if (type_ == StringValue)
+    text = new string(*other.text);
+  else
+    number = other.number;
+}
+
+TypedValue::TypedValue(TypedValue&& other) : type_(other.type_) {
+  if (type_ == StringValue)
+    text = other.text;
+  else
+    number = other.number;
+
+  other.type_ = IntValue;
+  other.number.numerator = 0;
+  other.number.denominator = 1;
+}
+
+TypedValue& TypedValue::operator=(const TypedValue& other) {
+  if (this == &other)
+    return *this;
+
+  //Strings reuse the text they already hold
+  if (type_ == StringValue && other.type_ == StringValue) {
+    *text = *other.text;
+    return *this;
+  }
+
+  if (other.type_ == StringValue) {
+    text = new string(*other.text);
+    type_ = StringValue;
+  }
+  else
+    setNumber(other.number.numerator, other.number.denominator, other.type_);
+  return *this;
+}
+
+TypedValue& TypedValue::operator=(TypedValue&& other) {
+  if (this == &other)
+    return *this;
+
+  if (type_ == StringValue)
+    delete text;
+
+  type_ = other.type_;
+  if (type_ == StringValue)
+    text = other.text;
+  else
+    number = other.number;
+
+  other.type_ = IntValue;
+  other.number.numerator = 0;
+  other.number.denominator = 1;
+  return *this;
+}
+
+/*
+* Read text as an int if it is written as << writes ints, "-12" but not "+12", "012" or "-0",
+* as a Fraction if it is written as << writes Fractions that are not whole, "-1+1/2" or "3/4"
+* but not "6/8" or "0+1/2", and as a string otherwise. Numbers must fit an int.
+*
+* Complexity: O(k) in the length of the text
+*/
+void TypedValue::assign(const char* str, size_t length) {
+  const char* p = str;
+  const char* end = str + length;
+
+  bool negative = p < end && *p == '-';
+  if (negative)
+    ++p;
+
+  long long first, whole = 0, n, d;
+  if (readInt(p, end, first)) {
+    if (p == end) {
+      long long val = negative ? -first : first;
+      if (!(negative && first == 0) && val >= INT_MIN && val <= INT_MAX) {
+        setNumber(int(val), 1, IntValue);
+        return;
+      }
+    }
+    else {
+      bool valid = true;
+      if (*p == '+') {
+        ++p;
+        whole = first;
+        valid = whole > 0 && readInt(p, end, n);
+      }
+      else
+        n = first;
+
+      valid = valid && p < end && *p == '/';
+      if (valid) {
+        ++p;
+        valid = readInt(p, end, d) && p == end && n > 0 && d > n && GCD(n, d) == 1;
+      }
+
+      long long num = valid ? whole * d + n : 0;
+      if (valid && num <= INT_MAX && d <= INT_MAX) {
+        setNumber(negative ? -int(num) : int(num), d, FractionValue);
+        return;
+      }
+    }
+  }
+
+  if (type_ == StringValue)
+    text->assign(str, length);
+  else {
+    text = new string(str, length);
+    type_ = StringValue;
+  }
+}
+
+/*
+* Complexity: O(1) between numbers, O(k) in the length of the text otherwise
+*/
+bool TypedValue::convert(ValueType type) {
+  if (type == type_)
+    return true;
+
+  if (type == StringValue) {
+    ostringstream out;
+    out << *this;
+    text = new string(out.str());
+    type_ = StringValue;
+    return true;
+  }
+
+  //Strings only become numbers when they read as one of no wider type
+  if (type_ == StringValue) {
+    TypedValue parsed;
+    parsed.assign(*text);
+    if (parsed.type_ > type)
+      return false;
+
+    parsed.type_ = type;
+    *this = std::move(parsed);
+    return true;
+  }
+
+  //Whole Fractions are written as ints
+  if (type == IntValue && number.denominator != 1)
+    return false;
+
+  type_ = type;
+  return true;
+}
+
+/*
+* Complexity: O(1) between numbers, O(k) in the length of the shorter text between strings
+*/
+int TypedValue::compare(const TypedValue& other) const {
+  if (type_ == StringValue || other.type_ == StringValue) {
+    if (type_ != StringValue)
+      return -1;
+    if (other.type_ != StringValue)
+      return 1;
+    return text->compare(*other.text);
+  }
+
+  if (number.denominator == 1 && other.number.denominator == 1)
+    return number.numerator < other.number.numerator ? -1 : number.numerator > other.number.numerator;
+
+  //Denominators are positive, so cross multiplying keeps the order
+  long long left = (long long)number.numerator * other.number.denominator;
+  long long right = (long long)other.number.numerator * number.denominator;
+  return left < right ? -1 : left > right;
+}
+
+/*
+* Values are written as their type writes them, which is the text they were read from
+*/
+ostream& operator<<(ostream& out, const TypedValue& val) {
+  switch (val.type_) {
+    case IntValue:
+      return out << val.number.numerator;
+    case FractionValue:
+      return out << val.fractionValue();
+    case StringValue:
+      return out << *val.text;
+  }
+  return out;
+}
+
+/*
+* Read the next whitespace delimited word as a value
+*/
+istream& operator>>(istream& in, TypedValue& val) {
+  string word;
+  if (in >> word)
+    val.assign(word);
+  return in;
+}
+
+const char* TypedValue::typeName(ValueType type) {
+  switch (type) {
+    case IntValue:
+      return "int";
+    case FractionValue:
+      return "fraction";
+    case StringValue:
+      return "string";
+  }
+  return "";
+}
+
+bool TypedValue::typeOf(const string& name, ValueType& type) {
+  for (int t = IntValue; t <= StringValue; ++t) {
+    if (name == typeName(ValueType(t))) {
+      type = ValueType(t);
+      return true;
+    }
+  }
+  return false;
+}
+
+
+//Private Helper functions
+
+/*
+* Become the number n/d of the given type, freeing any text.
+* Complexity: O(1)
+*/
+void TypedValue::setNumber(int n, int d, ValueType type) {
+  if (type_ == StringValue)
+    delete text;
+
+  type_ = type;
+  number.numerator = n;
+  number.denominator = d;
+}
+
+/*
+* Read the digits of a number as << writes them, without leading zeros, advancing p past them.
+* Magnitudes up to 2^31 are read, the caller checks the range of the signed number.
+* Complexity: O(1), at most 10 digits are read
+* Return: false if p does not start a number or the number does not fit
+*/
+bool TypedValue::readInt(const char*& p, const char* end, long long& val) {
+  if (p == end || *p < '0' || *p > '9' || (*p == '0' && p + 1 < end && p[1] >= '0' && p[1] <= '9'))
+    return false;
+
+  long long magnitude = 0;
+  int digits = 0;
+  for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+    if (++digits > 10)
+      return false;
+    magnitude = magnitude * 10 + (*p - '0');
+  }
+
+  val = magnitude;
+  return magnitude <= (long long)INT_MAX + 1;
+}
@@ -0,0 +1,124 @@
+/**
+*  Value of a typed database, which holds ints, Fractions and strings side by side.
+*
+*  Each value is tagged with its type and kept in 16 bytes: numbers are stored inline
+*  as a numerator and denominator (1 for ints), strings out of line. Text is read as
+*  the narrowest type that writes it back unchanged, so "12" is an int, "1+1/2" a
+*  Fraction and "012" or "N/A" a string, and a typed database writes out exactly
+*  what it read. Converting a value to a wider type never changes its text.
+*
+*  Numbers compare by value whatever their type and strings compare as text. Every
+*  number orders before every string, but equality and the < and > of queries only
+*  hold between values of the same kind, a number is never equal to a string.
+*
+*  Author: Mohammad Ghasembeigi
+*
+*/
+
+#ifndef TYPEDVALUE_H
+#define TYPEDVALUE_H
+
+#include <iostream>
+#include <string>
+#include <functional>
+
+using namespace std;
+
+#include "fraction.h"
+#include "memoryusage.h"
+
+//Types ordered from narrowest to widest, every value of a type can be written as any wider type
+enum ValueType { IntValue, FractionValue, StringValue };
+
+class TypedValue {
+public:
+  //Default constructor, the int 0
+  TypedValue() : type_(IntValue) { number.numerator = 0; number.denominator = 1; }
+
+  //Values of a given type
+  explicit TypedValue(int val) : type_(IntValue) { number.numerator = val; number.denominator = 1; }
+  explicit TypedValue(const Fraction& val);
+  explicit TypedValue(const string& val) : type_(StringValue), text(new string(val)) {}
+
+  //Copies take their own copy of a string
+  TypedValue(const TypedValue& other);
+  TypedValue(TypedValue&& other);
+  TypedValue& operator=(const TypedValue& other);
+  TypedValue& operator=(TypedValue&& other);
+
+  //Member functions
+
+  //Read text as the narrowest type that writes it back unchanged
+  void assign(const char* str, size_t length);
+  inline void assign(const string& str) { assign(str.data(), str.length()); }
+
+  //Convert to type when the text of the value stays the same, which is always the case for a wider type
+  //Return: false if the value can not be written as type, leaving it unchanged
+  bool convert(ValueType type);
+
+  //Complexity of inlines: O(1)
+  inline ValueType type() const { return type_; }
+  inline bool isNumber() const { return type_ != StringValue; }
+
+  //Parts of a number, an int is n/1. Only valid for numbers
+  inline int numerator() const { return number.numerator; }
+  inline int denominator() const { return number.denominator; }
+  inline Fraction fractionValue() const { return type_ == IntValue ? Fraction(number.numerator) : Fraction(number.numerator, number.denominator); }
+
+  //Text of a string. Only valid for strings
+  inline const string& stringValue() const { return *text; }
+
+  //Ordering of two values: negative, zero or positive as this orders before, with or after other
+  int compare(const TypedValue& other) const;
+
+  //Operator overloads
+  inline bool operator<(const TypedValue& other) const { return compare(other) < 0; }
+  inline bool operator>(const TypedValue& other) const { return compare(other) > 0; }
+  inline bool operator==(const TypedValue& other) const { return compare(other) == 0; }
+  inline bool operator!=(const TypedValue& other) const { return compare(other) != 0; }
+
+  friend ostream& operator<<(ostream& out, const TypedValue& val);
+  friend istream& operator>>(istream& in, TypedValue& val);
+
+  //Name of a type as the shell shows it, and the type of a name, false for an unknown name
+  static const char* typeName(ValueType type);
+  static bool typeOf(const string& name, ValueType& type);
+
+  //Frees the text of a string
+  ~TypedValue() { if (type_ == StringValue) delete text; }
+
+private:
+  ValueType type_;
+  union {
+    struct {
+      int numerator;
+      int denominator;   //positive, and 1 for ints
+    } number;
+    string* text;
+  };
+
+  //Private helper functions
+  void setNumber(int n, int d, ValueType type);
+  static bool readInt(const char*& p, const char* end, long long& val);
+
+};
+
+//Memory held by a string value, the string object and its text
+template <>
+inline size_t valueBytes(const TypedValue& val) {
+  return val.isNumber() ? 0 : allocationBytes(sizeof(string)) + stringBytes(val.stringValue());
+}
+
+//Equal numbers hash alike whatever their type, as reduced Fractions do
+namespace std {
+  template <>
+  struct hash<TypedValue> {
+    size_t operator()(const TypedValue& val) const {
+      if (!val.isNumber())
+        return hash<string>()(val.stringValue());
+      return hash<unsigned long long>()((static_cast<unsigned long long>(static_cast<unsigned>(val.numerator())) << 32) ^ static_cast<unsigned>(val.denominator()));
+    }
+  };
+}
+
+#endif
@@ -11,7 +11,7 @@
 #include <string>
 
 namespace {
-  void TrimString(std::string &s) {
+  inline void TrimString(std::string &s) {
     const std::string whitespace(" \f\n\r\t\v");
     std::string::size_type first_idx = s.find_first_not_of(whitespace);
     if (first_idx == std::string::npos) {
@@ -0,0 +1,82 @@
+/**
+*  Zone map (per block value ranges) used to skip records during select.
+*
+*  Records are grouped by position into fixed size blocks. Every block keeps
+*  the smallest and largest value of each attribute found in it, along with a
+*  small bloom filter of the attributes present. A query whose attribute is not
+*  in a block, or whose value lies outside the block's range, can not match any
+*  record of that block, so the whole block is skipped without visiting it.
+*
+*  Author: Mohammad Ghasembeigi
+*
+*/
+
+#ifndef ZONEMAP_H
+#define ZONEMAP_H
+
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+#include "record.h"
+#include "memoryusage.h"
+
+template <class value>
+class ZoneMap {
+public:
+  //Default constructor
+  ZoneMap<value>() : blocks(vector<Block>()), count(0), rangeBytes(0) {}
+
+  //Number of consecutive record positions summarised by each block
+  static const size_t BlockSize = 1024;
+
+  //Member functions
+  void clear();
+  void add(const Record<value>& r);
+  void widen(size_t position, Attribute attr, const value& val);
+  bool mayMatch(size_t block, Attribute attr, DBQueryOperator op, const value& want) const;
+
+  //Complexity of inlines: O(1)
+  inline size_t numBlocks() const { return blocks.size(); }
+  inline size_t size() const { return count; }
+  inline size_t memoryUsage() const { return vectorBytes(blocks) + rangeBytes; }
+
+  //Default Destructor
+  ~ZoneMap() {};
+
+private:
+  struct Range {
+    Range(Attribute attr, const value& min, const value& max) : attr(attr), min(min), max(max) {}
+
+    Attribute attr;
+    value min;
+    value max;
+  };
+
+  struct Block {
+    Block() : present(0), ranges(vector<Range>()) {}
+
+    uint64_t present;       //bloom filter of the attributes in the block
+    vector<Range> ranges;   //one entry per attribute in the block
+  };
+
+  vector<Block> blocks;
+  size_t count;   //number of records added
+  size_t rangeBytes;  //memory held by the ranges of every block, as if their vectors were full
+
+  //Private helper functions
+  void addRange(Block& block, Attribute attr, const value& val);
+  void setBound(value& bound, const value& val);
+
+  //Two bits of the bloom filter for an attribute, interned names are identified by address
+  static inline uint64_t bloomBits(Attribute attr) {
+    uint64_t h = uint64_t(uintptr_t(attr)) * 0x9E3779B97F4A7C15ull;
+    return (uint64_t(1) << (h >> 58)) | (uint64_t(1) << ((h >> 52) & 63));
+  }
+
+};
+
+#include "zonemap.tem"
+
+#endif